@@ -0,0 +1,321 @@
+/*
+ * benchmarks.cpp
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <numbers>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "entities/geometry/object.h"
+#include "entities/rendering/ansi.h"
+#include "entities/rendering/buffer.h"
+#include "entities/rendering/renderer.h"
+#include "entities/rendering/screen.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+#include "utils/algorithms.h"
+#include "config.h"
+
+// helpers
+
+// buffer with aspect of interactive mode
+static Buffer make_buffer(const unsigned int width, const unsigned int height)
+{
+    const float logical_y = 2.0f;
+    const float logical_x = logical_y * static_cast<float>(width) / (static_cast<float>(height) * CHAR_ASPECT_RATIO);
+    return {width, height, logical_x, logical_y};
+}
+
+// model prepared like in interactive mode without colors
+static bool prepare(Object &obj, const std::string &path)
+{
+    if (!obj.load(path, false, 1))
+        return false;
+
+    obj.normalize();
+    obj.scale(3.0f);
+    return true;
+}
+
+// n-gon in xy plane, every second vertex pulled inside when star
+static std::vector<Vec3> polygon(const size_t n, const bool star)
+{
+    std::vector<Vec3> points;
+    points.reserve(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const float angle = 2.0f * std::numbers::pi_v<float> * static_cast<float>(i) / static_cast<float>(n);
+        const float radius = star && (i % 2) ? 0.5f : 1.0f;
+        points.emplace_back(radius * std::cos(angle), radius * std::sin(angle), 0.0f);
+    }
+
+    return points;
+}
+
+// loading
+
+static void BM_Load(benchmark::State &state, const std::string &path)
+{
+    for (auto _ : state)
+    {
+        Object obj;
+        if (!obj.load(path, true, 1))
+        {
+            state.SkipWithError("load failed");
+            return;
+        }
+        benchmark::DoNotOptimize(obj.mesh.indices.data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(std::filesystem::file_size(path)));
+}
+
+// triangulation
+
+static void BM_Triangularize(benchmark::State &state, const bool star)
+{
+    const auto points = polygon(static_cast<size_t>(state.range(0)), star);
+
+    // scratch memory reused like in loader
+    Triangulator triangulator;
+    std::vector<unsigned int> triangles;
+
+    for (auto _ : state)
+    {
+        triangles.clear();
+        const bool ok = triangulator.triangulate(points.data(), points.size(), triangles);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(triangles.data());
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_Triangularize, convex, false)->RangeMultiplier(4)->Range(4, 4096)->Complexity();
+BENCHMARK_CAPTURE(BM_Triangularize, star, true)->RangeMultiplier(4)->Range(4, 4096)->Complexity();
+
+// rendering
+
+static void BM_Render(benchmark::State &state, const std::string &path)
+{
+    Object obj;
+    if (!prepare(obj, path))
+    {
+        state.SkipWithError("load failed");
+        return;
+    }
+
+    Buffer buf = make_buffer(static_cast<unsigned int>(state.range(0)), static_cast<unsigned int>(state.range(1)));
+    Camera cam;
+    const Light light;
+    size_t frame = 0;
+
+    Renderer renderer;
+    renderer.reserve(obj);
+
+    for (auto _ : state)
+    {
+        cam.azimuth = 0.05f * static_cast<float>(frame++);
+        buf.clear();
+        renderer.render(buf, obj, cam, light, false, false);
+        benchmark::DoNotOptimize(buf.glyphs.data());
+    }
+}
+
+// triangle covering about size x size characters, depth always passes
+static void BM_DrawProjection(benchmark::State &state)
+{
+    Buffer buf = make_buffer(400, 120);
+    const float extent_x = buf.dx * static_cast<float>(state.range(0));
+    const float extent_y = buf.dy * static_cast<float>(state.range(0));
+
+    float z = 1e6f;
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        // walk over buffer so different rows and columns are touched
+        const float ox = buf.dx * static_cast<float>((i * 37) % (buf.x / 2));
+        const float oy = buf.dy * static_cast<float>((i * 11) % (buf.y / 2));
+        i++;
+
+        const Projection projection(Vec3(ox, oy, z), Vec3(ox + extent_x, oy + extent_y * 0.3f, z), Vec3(ox + extent_x * 0.4f, oy + extent_y, z), '#');
+        buf.draw_projection(projection, projection.color, projection.material);
+        z -= 1.0f;
+
+        benchmark::DoNotOptimize(buf.depth.data());
+    }
+}
+
+BENCHMARK(BM_DrawProjection)->RangeMultiplier(2)->Range(1, 64);
+
+// terminal output
+
+// ncurses screen writing to /dev/null, terminal type forced so it works without tty
+class NullTerminal {
+public:
+    FILE *out = nullptr;
+    FILE *in = nullptr;
+    SCREEN *screen = nullptr;
+
+    NullTerminal(const int width, const int height)
+    {
+        setenv("TERM", "xterm-256color", 1);
+        setenv("COLUMNS", std::to_string(width).c_str(), 1);
+        setenv("LINES", std::to_string(height).c_str(), 1);
+
+        out = std::fopen("/dev/null", "w");
+        in = std::fopen("/dev/null", "r");
+        if (out && in)
+            screen = newterm(nullptr, out, in);
+        if (screen)
+            set_term(screen);
+    }
+
+    ~NullTerminal()
+    {
+        if (screen)
+        {
+            endwin();
+            delscreen(screen);
+        }
+        if (out)
+            std::fclose(out);
+        if (in)
+            std::fclose(in);
+    }
+};
+
+static void BM_Present(benchmark::State &state, const std::string &path)
+{
+    const auto width = static_cast<unsigned int>(state.range(0));
+    const auto height = static_cast<unsigned int>(state.range(1));
+
+    Object obj;
+    if (!prepare(obj, path))
+    {
+        state.SkipWithError("load failed");
+        return;
+    }
+
+    NullTerminal terminal(static_cast<int>(width), static_cast<int>(height));
+    if (!terminal.screen)
+    {
+        state.SkipWithError("no terminal");
+        return;
+    }
+
+    // two different frames presented in turn, every present writes real differences
+    Buffer frames[2] = {make_buffer(width, height), make_buffer(width, height)};
+    Camera cam;
+    const Light light;
+    Renderer renderer;
+
+    for (int k = 0; k < 2; k++)
+    {
+        cam.azimuth = 0.3f * static_cast<float>(k);
+        renderer.render(frames[k], obj, cam, light, false, false);
+    }
+
+    Screen screen;
+    size_t frame = 0;
+    unsigned long cells = 0;
+
+    for (auto _ : state)
+    {
+        screen.present(frames[frame++ % 2]);
+        screen.flush();
+        cells += screen.cells;
+    }
+
+    state.counters["cells"] = benchmark::Counter(static_cast<double>(cells), benchmark::Counter::kAvgIterations);
+}
+
+// same frames through raw ansi encoder, bytes go to /dev/null with one write each
+static void BM_PresentAnsi(benchmark::State &state, const std::string &path)
+{
+    const auto width = static_cast<unsigned int>(state.range(0));
+    const auto height = static_cast<unsigned int>(state.range(1));
+
+    Object obj;
+    if (!prepare(obj, path))
+    {
+        state.SkipWithError("load failed");
+        return;
+    }
+
+    const int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        state.SkipWithError("no /dev/null");
+        return;
+    }
+
+    Buffer frames[2] = {make_buffer(width, height), make_buffer(width, height)};
+    Camera cam;
+    const Light light;
+    Renderer renderer;
+
+    for (int k = 0; k < 2; k++)
+    {
+        cam.azimuth = 0.3f * static_cast<float>(k);
+        renderer.render(frames[k], obj, cam, light, false, false);
+    }
+
+    AnsiScreen screen(obj.materials, "\x1b[0m", "\x1b[39m", fd);
+    size_t frame = 0;
+    unsigned long cells = 0, bytes = 0;
+
+    for (auto _ : state)
+    {
+        screen.present(frames[frame++ % 2]);
+        screen.flush();
+        cells += screen.cells;
+        bytes += screen.bytes;
+    }
+
+    state.counters["cells"] = benchmark::Counter(static_cast<double>(cells), benchmark::Counter::kAvgIterations);
+    state.counters["bytes"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+    ::close(fd);
+}
+
+// model benchmarks are registered for every bundled file
+
+int main(int argc, char **argv)
+{
+    std::vector<std::filesystem::path> models;
+    for (const auto &entry : std::filesystem::directory_iterator(RESOURCES_DIR))
+    {
+        if (entry.path().extension() == ".obj")
+            models.push_back(entry.path());
+    }
+    std::ranges::sort(models);
+
+    for (const auto &model : models)
+    {
+        const std::string path = model.string();
+        const std::string name = model.stem().string();
+
+        benchmark::RegisterBenchmark(("BM_Load/" + name).c_str(), BM_Load, path)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("BM_Render/" + name).c_str(), BM_Render, path)->Args({160, 50})->Args({400, 120})->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("BM_Present/" + name).c_str(), BM_Present, path)->Args({160, 50})->Args({400, 120})->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("BM_PresentAnsi/" + name).c_str(), BM_PresentAnsi, path)->Args({160, 50})->Args({400, 120})->Unit(benchmark::kMicrosecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 // cli draw
 inline constexpr char CHARS_LUM[] = " .:-=+*#%@";
 inline constexpr float CHAR_ASPECT_RATIO = 2.0f;
@@ -21,3 +23,52 @@ inline constexpr float AZIMUTH_START = 0.00f;
 inline constexpr float FRAME_DURATION = 1.0f / 60.0f; // 60 fps
 inline constexpr float ANIMATION_STEP_ALTITUDE = 30.0f;
 inline constexpr float ANIMATION_STEP_AZIMUTH = 30.0f;
+inline constexpr float FRAME_COST_SMOOTHING = 0.1f;     // weight of newest frame in average frame cost
+inline constexpr float FRAME_RATE_HYSTERESIS = 0.8f;    // faster rate is taken once cost is below this part of its interval
+
+// loading
+inline constexpr size_t LOAD_CHUNK_SIZE = 1 << 20; // bytes of obj file parsed by one task
+inline constexpr size_t LOAD_WAVE_CHUNKS = 16;      // chunks parsed together before progressive load publishes them
+inline constexpr float LOAD_SNAPSHOT_GROWTH = 2.0f; // preview is replaced once faces grow by this factor
+inline constexpr float LOAD_WELD_TOLERANCE = 1e-6f; // vertices closer than this fraction of model size are merged
+
+// rasterization
+inline constexpr unsigned int RASTER_TILE_X = 64; // tile size in characters for parallel drawing
+inline constexpr unsigned int RASTER_TILE_Y = 16;
+inline constexpr unsigned int HIZ_BLOCK_X = 8;    // pixels sharing one max depth for occlusion rejection, divides tile size
+inline constexpr unsigned int HIZ_BLOCK_Y = 4;
+inline constexpr int HIZ_MIN_PIXELS = 64;         // smaller triangles are cheaper to z-test than to check against blocks
+
+// ansi output
+inline constexpr unsigned int ANSI_GAP_CELLS = 3;   // unchanged cells rewritten between runs, cheaper than cursor move
+
+// turntable cache
+inline constexpr size_t TURNTABLE_MAX_FRAMES = 7200;    // longer animation loops are rendered live
+
+// profiler
+inline constexpr size_t PROFILE_FRAMES = 4096;      // frames kept for hud and dump
+inline constexpr size_t PROFILE_HUD_FRAMES = 30;    // frames averaged by hud pages
+
+// benchmark
+inline constexpr unsigned int BENCH_WIDTH = 160;        // default buffer size of headless run
+inline constexpr unsigned int BENCH_HEIGHT = 50;
+inline constexpr float BENCH_ORBIT_ALTITUDE = 0.5f;     // altitude swing of orbit, radians
+
+// level of detail
+inline constexpr size_t LOD_MIN_FACES = 20000;      // smaller meshes are drawn as they are
+inline constexpr unsigned int LOD_GRID_MAX = 1024;  // cells along longest side of finest level
+inline constexpr unsigned int LOD_GRID_MIN = 16;    // cells along longest side of coarsest level
+inline constexpr float LOD_MIN_REDUCTION = 0.75f;   // level is kept only below this fraction of previous faces
+inline constexpr float LOD_MAX_ERROR = 0.5f;        // allowed vertex displacement, fraction of character
+
+// materials
+inline constexpr size_t MATERIAL_CACHE_BYTES = 16 << 20;   // mtl text and tables kept for reuse by later models
+
+// streaming
+inline constexpr size_t STREAM_CLUSTER_FACES = 4096;    // faces per paged cluster, subtrees of hierarchy up to this size
+inline constexpr size_t STREAM_BLOCK_ALIGN = 65536;     // file alignment of cluster data, largest page size so clusters never share a page
+inline constexpr size_t STREAM_HULL_VERTICES = 65536;   // coarsest level up to this size centers model, bounding box otherwise
+
+// culling
+inline constexpr unsigned int BVH_LEAF_FACES = 64;  // faces per leaf of hierarchy
+inline constexpr float BVH_CONE_MARGIN = 1e-3f;     // radians added to normal cones against rounding of per-face test
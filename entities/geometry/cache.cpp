@@ -0,0 +1,212 @@
+/*
+ * cache.cpp
+ */
+
+#include "cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+// layout of sidecar:
+// header | x, y, z float[vertex_count] | indices uint32[3 * face_count] | materials uint16[face_count] | material table
+// material table entry: uint32 name length | name chars | float[3] diffuse
+
+static constexpr char CACHE_MAGIC[4] = {'O', 'B', 'J', 'C'};
+static constexpr uint32_t CACHE_VERSION = 3;
+static constexpr uint32_t CACHE_FLAG_COLOR = 1u << 0;
+
+class CacheHeader {
+public:
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t flags;
+    uint32_t vertex_count;
+    uint32_t face_count;
+    uint32_t material_count;
+};
+
+static_assert(sizeof(CacheHeader) == 40, "sidecar header must stay packed");
+
+bool MeshCache::Source::stat(const std::string &filename, Source &source)
+{
+    struct stat st{};
+    if (::stat(filename.c_str(), &st) != 0)
+    {
+        return false;
+    }
+
+    source.size = static_cast<uint64_t>(st.st_size);
+    source.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+std::filesystem::path MeshCache::path_for(const std::string &obj_filename)
+{
+    return std::filesystem::path(obj_filename).replace_extension(".objc");
+}
+
+bool MeshCache::load(Object &obj, const std::string &obj_filename, const bool color_support)
+{
+    Source source;
+    if (!Source::stat(obj_filename, source))
+    {
+        return false;
+    }
+
+    const auto cache_filename = path_for(obj_filename);
+    if (!std::filesystem::exists(cache_filename))
+    {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(cache_filename.string()))
+    {
+        return false;
+    }
+
+    BoundedReader reader(file.view());
+
+    CacheHeader header{};
+    if (!reader.read(&header, sizeof(header)) || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION
+        || header.vertex_count == 0 || header.face_count == 0)
+    {
+        std::cerr << "warning: ignoring invalid cache " << cache_filename.string() << std::endl;
+        return false;
+    }
+
+    // stale or written with other color setting
+    const uint32_t flags = color_support ? CACHE_FLAG_COLOR : 0;
+    if (header.source_size != source.size || header.source_mtime != source.mtime || header.flags != flags)
+    {
+        return false;
+    }
+
+    Object loaded;
+    Mesh &mesh = loaded.mesh;
+
+    mesh.x.resize(header.vertex_count);
+    mesh.y.resize(header.vertex_count);
+    mesh.z.resize(header.vertex_count);
+    mesh.indices.resize(static_cast<size_t>(header.face_count) * 3);
+    mesh.materials.resize(header.face_count);
+
+    // mesh arrays are stored as is
+    bool ok = reader.read(mesh.x.data(), mesh.x.size() * sizeof(float))
+           && reader.read(mesh.y.data(), mesh.y.size() * sizeof(float))
+           && reader.read(mesh.z.data(), mesh.z.size() * sizeof(float))
+           && reader.read(mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int))
+           && reader.read(mesh.materials.data(), mesh.materials.size() * sizeof(uint16_t));
+
+    for (uint32_t i = 0; ok && i < header.material_count; i++)
+    {
+        uint32_t length = 0;
+        std::string name;
+        float diffuse[3];
+
+        ok = reader.read(&length, sizeof(length)) && reader.read_string(name, length) && reader.read(diffuse, sizeof(diffuse));
+        if (ok)
+        {
+            loaded.materials.emplace_back(name, Vec3(diffuse[0], diffuse[1], diffuse[2]));
+        }
+    }
+
+    if (!ok)
+    {
+        std::cerr << "warning: ignoring truncated cache " << cache_filename.string() << std::endl;
+        return false;
+    }
+
+    const bool valid_indices = std::ranges::all_of(mesh.indices, [&](const unsigned int idx) { return idx < header.vertex_count; });
+    const bool valid_materials = std::ranges::all_of(mesh.materials, [&](const uint16_t m) { return m == NO_MATERIAL || m < header.material_count; });
+
+    if (!valid_indices || !valid_materials)
+    {
+        std::cerr << "warning: ignoring invalid cache " << cache_filename.string() << std::endl;
+        return false;
+    }
+
+    mesh.compute_normals();
+
+    obj = std::move(loaded);
+    return true;
+}
+
+bool MeshCache::save(const Object &obj, const std::string &obj_filename, const bool color_support)
+{
+    Source source;
+    if (!Source::stat(obj_filename, source))
+    {
+        return false;
+    }
+
+    const auto cache_filename = path_for(obj_filename);
+    const auto temp_filename = unique_temp(cache_filename);
+    if (temp_filename.empty())
+    {
+        std::cerr << "warning: can't write cache " << cache_filename.string() << std::endl;
+        return false;
+    }
+
+    // temp file is own to this writer, so truncating it touches no other one
+    std::ofstream out(temp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "warning: can't write cache " << cache_filename.string() << std::endl;
+        std::filesystem::remove(temp_filename);
+        return false;
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+    header.flags = color_support ? CACHE_FLAG_COLOR : 0;
+    const Mesh &mesh = obj.mesh;
+    header.vertex_count = static_cast<uint32_t>(mesh.vertex_count());
+    header.face_count = static_cast<uint32_t>(mesh.face_count());
+    header.material_count = static_cast<uint32_t>(obj.materials.size());
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(mesh.x.data()), static_cast<std::streamsize>(mesh.x.size() * sizeof(float)));
+    out.write(reinterpret_cast<const char *>(mesh.y.data()), static_cast<std::streamsize>(mesh.y.size() * sizeof(float)));
+    out.write(reinterpret_cast<const char *>(mesh.z.data()), static_cast<std::streamsize>(mesh.z.size() * sizeof(float)));
+    out.write(reinterpret_cast<const char *>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(unsigned int)));
+    out.write(reinterpret_cast<const char *>(mesh.materials.data()), static_cast<std::streamsize>(mesh.materials.size() * sizeof(uint16_t)));
+
+    for (const auto &material : obj.materials)
+    {
+        const auto length = static_cast<uint32_t>(material.material_name.size());
+        const float diffuse[3] = {material.diffuse.x, material.diffuse.y, material.diffuse.z};
+
+        out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        out.write(material.material_name.data(), length);
+        out.write(reinterpret_cast<const char *>(diffuse), sizeof(diffuse));
+    }
+
+    out.close();
+    if (!out)
+    {
+        std::cerr << "warning: can't write cache " << cache_filename.string() << std::endl;
+        std::filesystem::remove(temp_filename);
+        return false;
+    }
+
+    // replace atomically, readers never see half written sidecar and last writer wins
+    std::error_code ec;
+    std::filesystem::rename(temp_filename, cache_filename, ec);
+    if (ec)
+    {
+        std::cerr << "warning: can't write cache " << cache_filename.string() << std::endl;
+        std::filesystem::remove(temp_filename, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+/*
+ * cache.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "object.h"
+
+// binary sidecar (.objc) with loaded and triangulated state of object
+class MeshCache {
+public:
+    // sidecar path for obj file - same name with .objc extension
+    static std::filesystem::path path_for(const std::string &obj_filename);
+
+    // restore object from sidecar, fails if sidecar is missing or obj file has changed since
+    static bool load(Object &obj, const std::string &obj_filename, bool color_support);
+
+    // write sidecar for freshly loaded object
+    static bool save(const Object &obj, const std::string &obj_filename, bool color_support);
+
+    // identity of source file, cache is valid while it matches
+    class Source {
+    public:
+        uint64_t size = 0;
+        int64_t mtime = 0;      // nanoseconds
+
+        static bool stat(const std::string &filename, Source &source);
+    };
+};
@@ -0,0 +1,94 @@
+/*
+ * loader.cpp
+ */
+
+#include "loader.h"
+
+#include "cache.h"
+
+ModelLoader::ModelLoader(std::string filename, const bool color_support, const bool use_cache, const unsigned threads, Prepare prepare, Restore restore)
+    : filename(std::move(filename)), color_support(color_support), use_cache(use_cache), threads(threads), prepare(std::move(prepare)), restore(std::move(restore))
+{
+    worker = std::thread(&ModelLoader::run, this);
+}
+
+ModelLoader::~ModelLoader()
+{
+    // parser stops at next wave
+    cancel.store(true);
+    worker.join();
+}
+
+std::shared_ptr<const Object> ModelLoader::take()
+{
+    wake.drain();
+
+    std::lock_guard lock(mutex);
+    return std::move(latest);
+}
+
+void ModelLoader::publish(std::shared_ptr<const Object> obj)
+{
+    {
+        std::lock_guard lock(mutex);
+        latest = std::move(obj);
+    }
+    wake.notify();
+}
+
+void ModelLoader::run()
+{
+    Object obj;
+    if (restore && restore(obj))
+    {
+        publish(std::make_shared<const Object>(std::move(obj)));
+        fraction.store(1.0f);
+        state.store(State::Done);
+        wake.notify();
+        return;
+    }
+
+    bool ok = use_cache && MeshCache::load(obj, filename, color_support);
+
+    if (!ok)
+    {
+        size_t shown = 0;   // faces of newest preview
+
+        // preview only after faces grew by constant factor, copies of all previews together stay linear in file size
+        const auto observer = [&](const Object &partial, const float progress) {
+            fraction.store(progress);
+
+            const size_t faces = partial.mesh.face_count();
+            if (progress < 1.0f && faces > 0 && static_cast<float>(faces) >= LOAD_SNAPSHOT_GROWTH * static_cast<float>(shown))
+            {
+                auto preview = std::make_shared<Object>(partial);
+                prepare(*preview, false);
+                publish(std::move(preview));
+                shown = faces;
+            }
+            else
+            {
+                wake.notify();
+            }
+
+            return !cancel.load();
+        };
+
+        ok = obj.load(filename, color_support, threads, observer);
+
+        if (ok && use_cache)
+        {
+            MeshCache::save(obj, filename, color_support);
+        }
+    }
+
+    if (ok && !cancel.load())
+    {
+        prepare(obj, true);
+        publish(std::make_shared<const Object>(std::move(obj)));
+    }
+
+    fraction.store(1.0f);
+    state.store(ok ? State::Done : State::Failed);
+    wake.notify();
+}
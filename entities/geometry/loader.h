@@ -0,0 +1,64 @@
+/*
+ * loader.h
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "object.h"
+#include "utils/notifier.h"
+
+// loads model on own thread, faces parsed so far are published as previews while rest of file is read
+class ModelLoader {
+public:
+    // makes loaded object ready for rendering, complete is false for previews of partial file
+    using Prepare = std::function<void(Object &obj, bool complete)>;
+
+    // takes model ready for rendering from elsewhere (streamed sidecar), true skips parsing and prepare
+    using Restore = std::function<bool(Object &obj)>;
+
+    // use_cache - take .objc sidecar if valid and write it after parsing
+    ModelLoader(std::string filename, bool color_support, bool use_cache, unsigned threads, Prepare prepare, Restore restore = {});
+    ~ModelLoader();     // cancels loading
+
+    ModelLoader(const ModelLoader &) = delete;
+    ModelLoader &operator=(const ModelLoader &) = delete;
+
+    // newest model not taken yet, nullptr if none, complete model comes last
+    [[nodiscard]] std::shared_ptr<const Object> take();
+
+    [[nodiscard]] float progress() const { return fraction.load(); }    // part of file parsed, 0-1
+    [[nodiscard]] bool loading() const { return state.load() == State::Loading; }
+    [[nodiscard]] bool failed() const { return state.load() == State::Failed; }
+
+    // readable after new model or progress, for waiting on input together with loading
+    [[nodiscard]] int notifier() const { return wake.fd(); }
+
+private:
+    enum class State { Loading, Done, Failed };
+
+    const std::string filename;
+    const bool color_support, use_cache;
+    const unsigned threads;
+    const Prepare prepare;
+    const Restore restore;
+
+    std::mutex mutex;
+    std::shared_ptr<const Object> latest;   // guarded by mutex
+
+    std::atomic<float> fraction{0.0f};
+    std::atomic<State> state{State::Loading};
+    std::atomic<bool> cancel{false};
+    Notifier wake;
+
+    std::thread worker;
+
+    void run();
+    void publish(std::shared_ptr<const Object> obj);
+};
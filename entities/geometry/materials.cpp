@@ -0,0 +1,185 @@
+/*
+ * materials.cpp
+ */
+
+#include "materials.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "utils/files.h"
+#include "utils/tools.h"
+
+// fnv-1a, 64 bit
+static uint64_t hash_bytes(const void *data, const size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// parse kd
+static bool parse_diffuse_color(std::string_view line, Vec3 &current_diffuse)
+{
+    const auto r = parse_float(next_token(line));
+    const auto g = parse_float(next_token(line));
+    const auto b = parse_float(next_token(line));
+
+    if (!r || !g || !b)
+    {
+        std::cerr << "error: can't parse diffuse colors" << std::endl;
+        return false;
+    }
+
+    current_diffuse = Vec3(*r, *g, *b);
+    return true;
+}
+
+MaterialLibrary MaterialLibrary::parse(std::string_view text)
+{
+    MaterialLibrary library;
+    library.hash = hash_bytes(text.data(), text.size());
+
+    std::string current_name;
+    Vec3 current_diffuse(1.0f, 1.0f, 1.0f);
+    bool have_active_material = false;
+
+    while (!text.empty())
+    {
+        const std::string_view line = next_line(text);
+
+        std::string_view cmd;
+        std::string_view arguments;
+        if (!split_command(line, cmd, arguments))
+        {
+            continue;
+        }
+
+        if (cmd == "newmtl") // current material
+        {
+            if (have_active_material)
+            {
+                library.materials.emplace_back(current_name, current_diffuse);
+            }
+
+            const std::string_view name = next_token(arguments);
+            if (name.empty())
+            {
+                std::cerr << "error: can't parse material name" << std::endl;
+                continue;
+            }
+
+            current_name = name;
+            current_diffuse = Vec3(1.0f, 1.0f, 1.0f);
+            have_active_material = true;
+        }
+        else if (cmd == "Kd") // diffuse color
+        {
+            parse_diffuse_color(arguments, current_diffuse);
+        }
+    }
+
+    if (have_active_material)
+    {
+        library.materials.emplace_back(current_name, current_diffuse);
+    }
+
+    return library;
+}
+
+uint64_t material_hash(const std::vector<Material> &materials)
+{
+    uint64_t hash = hash_bytes(nullptr, 0);
+    for (const auto &material : materials)
+    {
+        const auto length = static_cast<uint32_t>(material.material_name.size());
+        const float diffuse[3] = {material.diffuse.x, material.diffuse.y, material.diffuse.z};
+
+        hash = hash_bytes(&length, sizeof(length), hash);
+        hash = hash_bytes(material.material_name.data(), length, hash);
+        hash = hash_bytes(diffuse, sizeof(diffuse), hash);
+    }
+    return hash;
+}
+
+std::mutex MaterialCache::mutex;
+std::list<MaterialCache::Entry> MaterialCache::entries;
+std::unordered_map<uint64_t, std::list<MaterialCache::Entry>::iterator> MaterialCache::by_hash;
+size_t MaterialCache::cached_bytes = 0;
+
+std::shared_ptr<const MaterialLibrary> MaterialCache::load(const std::string &mtl_filename)
+{
+    MappedFile file;
+    if (!file.open(mtl_filename))
+    {
+        return nullptr;
+    }
+
+    const std::string_view text = file.view();
+    const uint64_t hash = hash_bytes(text.data(), text.size());
+
+    {
+        std::lock_guard lock(mutex);
+        const auto it = by_hash.find(hash);
+        if (it != by_hash.end() && it->second->text == text)
+        {
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->library;
+        }
+    }
+
+    // parsed outside of lock, of two threads parsing same contents first one to publish wins
+    auto library = std::make_shared<const MaterialLibrary>(MaterialLibrary::parse(text));
+
+    size_t bytes = text.size();
+    for (const auto &material : library->materials)
+        bytes += sizeof(Material) + material.material_name.capacity();
+
+    std::lock_guard lock(mutex);
+
+    // other contents under same hash or too big to keep - used without caching
+    if (const auto it = by_hash.find(hash); it != by_hash.end())
+    {
+        return it->second->text == text ? it->second->library : library;
+    }
+
+    if (bytes > MATERIAL_CACHE_BYTES)
+    {
+        return library;
+    }
+
+    entries.push_front({std::string(text), library, bytes});
+    by_hash.emplace(hash, entries.begin());
+    cached_bytes += bytes;
+
+    while (cached_bytes > MATERIAL_CACHE_BYTES)
+    {
+        const Entry &oldest = entries.back();
+        cached_bytes -= oldest.bytes;
+        by_hash.erase(oldest.library->hash);
+        entries.pop_back();
+    }
+
+    return library;
+}
+
+void MaterialPrefetch::request(const std::string &mtl_filename)
+{
+    if (std::ranges::any_of(pending, [&](const auto &entry) { return entry.first == mtl_filename; }))
+    {
+        return;
+    }
+
+    pending.emplace_back(mtl_filename, std::async(std::launch::async, &MaterialCache::load, mtl_filename).share());
+}
+
+std::shared_ptr<const MaterialLibrary> MaterialPrefetch::take(const std::string &mtl_filename)
+{
+    const auto it = std::ranges::find_if(pending, [&](const auto &entry) { return entry.first == mtl_filename; });
+    return it != pending.end() ? it->second.get() : MaterialCache::load(mtl_filename);
+}
@@ -0,0 +1,67 @@
+/*
+ * materials.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "object.h"
+
+// parsed mtl file, never changes once published so objects share it without locking
+class MaterialLibrary {
+public:
+    std::vector<Material> materials;    // in definition order, redefinitions keep own entry
+    uint64_t hash = 0;                  // of file contents
+
+    // newmtl and Kd statements of mtl text, anything else is ignored
+    static MaterialLibrary parse(std::string_view text);
+};
+
+// content hash of material table, tables with same names and colors in same order hash equal
+uint64_t material_hash(const std::vector<Material> &materials);
+
+// process wide libraries by content, equal files under any path are parsed once while they stay cached,
+// least recently used ones are dropped once cached text and tables exceed MATERIAL_CACHE_BYTES
+class MaterialCache {
+public:
+    // library of mtl file, nullptr if file can't be read
+    static std::shared_ptr<const MaterialLibrary> load(const std::string &mtl_filename);
+
+private:
+    // cached library with text it was parsed from, hit is confirmed by comparing text
+    class Entry {
+    public:
+        std::string text;
+        std::shared_ptr<const MaterialLibrary> library;
+        size_t bytes;   // text and parsed table
+    };
+
+    // guarded by mutex, list from most to least recently used
+    static std::mutex mutex;
+    static std::list<Entry> entries;
+    static std::unordered_map<uint64_t, std::list<Entry>::iterator> by_hash;
+    static size_t cached_bytes;
+};
+
+// libraries requested before obj parsing reaches them, parsed on own threads meanwhile
+class MaterialPrefetch {
+public:
+    // starts loading unless requested already
+    void request(const std::string &mtl_filename);
+
+    // requested library once parsed, loaded now if it was not requested
+    std::shared_ptr<const MaterialLibrary> take(const std::string &mtl_filename);
+
+private:
+    std::vector<std::pair<std::string, std::shared_future<std::shared_ptr<const MaterialLibrary>>>> pending;
+};
@@ -4,6 +4,9 @@
 
 #include "object.h"
 
+#include "materials.h"
+#include "stream.h"
+
 // helper functions
 
 // from obj index to vector index
@@ -18,357 +21,1010 @@ static int relative_index(const int idx, int total_vertices)
     return idx < 0 ? total_vertices + idx : idx - 1;
 }
 
-// clean string
-static void strip_line(std::string &line)
+// from material table index to compact face material
+static uint16_t material_id(const std::optional<int> material)
 {
-    std::erase_if(line, [](const char c) { return c == '\r' || c == '\n'; });
-    std::ranges::replace(line, '\t', ' ');
+    if (!material || *material >= NO_MATERIAL)
+    {
+        return NO_MATERIAL;
+    }
+
+    return static_cast<uint16_t>(*material);
 }
 
-// check open file
-static std::optional<std::ifstream> open_file(const std::string &filename)
+// cut text into pieces of about chunk_size bytes on line boundaries
+static std::vector<std::string_view> split_chunks(std::string_view text, const size_t chunk_size)
 {
-    std::ifstream in(filename, std::ios::in | std::ios::binary);
-    if (!in.is_open())
+    std::vector<std::string_view> chunks;
+
+    while (!text.empty())
     {
-        std::cerr << "error: can't open file " << filename << std::endl;
-        return std::nullopt;
+        size_t end = std::min(chunk_size, text.size());
+        if (end < text.size())
+        {
+            const size_t newline = text.find('\n', end);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+
+        chunks.push_back(text.substr(0, end));
+        text.remove_prefix(end);
     }
 
-    return in;
+    return chunks;
 }
 
-// parse functions
+// chunk of obj file
+class Object::Chunk {
+public:
+    // face as written in file, indices are not resolved yet
+    class RawFace {
+    public:
+        size_t first;                   // first index in tokens
+        unsigned int count;             // number of indices
+        unsigned int vertices_before;   // vertices of chunk defined before face
+        int command;                    // last usemtl in chunk before face, -1 - none
+    };
 
-bool Object::validate() const
+    // mtllib or usemtl, resolved in file order after parallel pass
+    class Command {
+    public:
+        bool library;                   // mtllib if true, usemtl otherwise
+        std::string_view argument;
+        uint16_t material;              // resolved usemtl material
+    };
+
+    std::string_view text;
+
+    // vertices filled by parse_chunk, faces by resolve_faces
+    Mesh part;
+
+    // filled by parse_chunk
+    std::vector<int> tokens;
+    std::vector<RawFace> raw_faces;
+    std::vector<Command> commands;
+    int last_usemtl = -1;
+    bool ok = true;
+
+    // filled by sequential pass
+    unsigned int vertex_base = 0;               // vertices defined in previous chunks
+    uint16_t initial_material = NO_MATERIAL;    // material active at chunk start
+};
+
+// Mesh methods
+
+void Mesh::add_vertex(const Vec3 &v)
+{
+    x.push_back(v.x);
+    y.push_back(v.y);
+    z.push_back(v.z);
+}
+
+void Mesh::add_face(const unsigned int idx1, const unsigned int idx2, const unsigned int idx3, const uint16_t material)
+{
+    indices.insert(indices.end(), {idx1, idx2, idx3});
+    materials.push_back(material);
+}
+
+void Mesh::compute_normals()
 {
-    if (vertices.empty() || faces.empty())
+    const size_t n = face_count();
+
+    luminance.clear();
+
+    nx.resize(n);
+    ny.resize(n);
+    nz.resize(n);
+
+    for (size_t f = 0; f < n; f++)
     {
-        std::cerr << "error: invalid object" << std::endl;
-        return false;
+        const Vec3 v1 = vertex(indices[3 * f]);
+        const Vec3 v2 = vertex(indices[3 * f + 1]);
+        const Vec3 v3 = vertex(indices[3 * f + 2]);
+
+        const Vec3 normal = Vec3::cross(v2 - v1, v3 - v1).normalize();
+        nx[f] = normal.x;
+        ny[f] = normal.y;
+        nz[f] = normal.z;
+    }
+}
+
+size_t Mesh::weld(const float tolerance)
+{
+    constexpr unsigned int EMPTY = ~0u;
+
+    const size_t vcount = vertex_count();
+    const size_t fcount = face_count();
+
+    if (vcount == 0 || !(tolerance > 0.0f))
+    {
+        return 0;
     }
 
-    size_t n = vertices.size();
-    for (const auto &f : faces)
+    // cells much larger than tolerance, neighbour cell is searched only on axes where vertex is that close to cell border
+    constexpr float CELL_TOLERANCES = 64.0f;
+    const float inverse = 1.0f / (CELL_TOLERANCES * tolerance);
+    const float margin = 1.0f / CELL_TOLERANCES;
+    const float limit = tolerance * tolerance;
+
+    auto cell_of = [&](const float value) { return static_cast<int64_t>(std::floor(value * inverse)); };
+    auto hash_of = [](const int64_t cx, const int64_t cy, const int64_t cz) {
+        return static_cast<uint64_t>(cx) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(cy) * 0xC2B2AE3D27D4EB4Full ^ static_cast<uint64_t>(cz) * 0x165667B19E3779F9ull;
+    };
+
+    // open addressing over kept vertices, one cell may hold several of them
+    size_t capacity = 1;
+    while (capacity < 2 * vcount)
+        capacity <<= 1;
+
+    const size_t mask = capacity - 1;
+    std::vector<unsigned int> table(capacity, EMPTY);
+    std::vector<unsigned int> remap(vcount);
+
+    for (size_t i = 0; i < vcount; i++)
     {
-        for (auto idx : f.indices)
+        const float scaled[3] = {x[i] * inverse, y[i] * inverse, z[i] * inverse};
+        const int64_t cell[3] = {cell_of(x[i]), cell_of(y[i]), cell_of(z[i])};
+
+        // -1 or 1 towards border closer than tolerance, 0 if vertex is deep inside
+        int64_t side[3];
+        for (size_t a = 0; a < 3; a++)
         {
-            if (idx >= n)
+            const float offset = scaled[a] - static_cast<float>(cell[a]);
+            side[a] = offset < margin ? -1 : offset > 1.0f - margin ? 1 : 0;
+        }
+
+        // first kept vertex closer than tolerance
+        unsigned int found = EMPTY;
+        for (unsigned int corner = 0; corner < 8 && found == EMPTY; corner++)
+        {
+            if (((corner & 1) && side[0] == 0) || ((corner & 2) && side[1] == 0) || ((corner & 4) && side[2] == 0))
+                continue;
+
+            const int64_t cx = cell[0] + ((corner & 1) ? side[0] : 0);
+            const int64_t cy = cell[1] + ((corner & 2) ? side[1] : 0);
+            const int64_t cz = cell[2] + ((corner & 4) ? side[2] : 0);
+
+            for (size_t slot = hash_of(cx, cy, cz) & mask; table[slot] != EMPTY; slot = (slot + 1) & mask)
             {
-                std::cerr << "error: invalid object" << std::endl;
-                return false;
+                const unsigned int k = table[slot];
+                if (cell_of(x[k]) != cx || cell_of(y[k]) != cy || cell_of(z[k]) != cz)
+                    continue;
+
+                const float dx = x[k] - x[i], dy = y[k] - y[i], dz = z[k] - z[i];
+                if (dx * dx + dy * dy + dz * dz < limit)
+                {
+                    found = k;
+                    break;
+                }
             }
         }
+
+        if (found != EMPTY)
+        {
+            remap[i] = found;
+            continue;
+        }
+
+        size_t slot = hash_of(cell[0], cell[1], cell[2]) & mask;
+        while (table[slot] != EMPTY)
+            slot = (slot + 1) & mask;
+
+        table[slot] = static_cast<unsigned int>(i);
+        remap[i] = static_cast<unsigned int>(i);
     }
 
-    return true;
-}
+    // faces with two corners on one vertex have no area
+    std::vector<bool> keep(fcount);
+    size_t kept_faces = 0;
+    for (size_t f = 0; f < fcount; f++)
+    {
+        unsigned int *face = &indices[3 * f];
+        for (size_t k = 0; k < 3; k++)
+            face[k] = remap[face[k]];
 
-// parse v x y z
-bool Object::parse_vertex(const std::string &line)
-{
-    std::stringstream ss(line);
+        keep[f] = face[0] != face[1] && face[1] != face[2] && face[0] != face[2];
+        kept_faces += keep[f];
+    }
 
-    float x, y, z;
-    if (!(ss >> x >> y >> z))
+    auto compact = [&](auto &values, const size_t stride) {
+        if (values.size() != fcount * stride)
+            return;
+
+        size_t out = 0;
+        for (size_t f = 0; f < fcount; f++)
+        {
+            if (!keep[f])
+                continue;
+
+            std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(f * stride), stride, values.begin() + static_cast<std::ptrdiff_t>(out * stride));
+            out++;
+        }
+        values.resize(out * stride);
+    };
+
+    if (kept_faces < fcount)
     {
-        std::cerr << "warning: invalid vertex format" << std::endl;
-        return false;
+        compact(indices, 3);
+        compact(materials, 1);
+        compact(nx, 1);
+        compact(ny, 1);
+        compact(nz, 1);
+        compact(luminance, 1);
     }
 
-    vertices.emplace_back(x, y, z);
-    return true;
+    // merged and unreferenced vertices go away, others keep their order
+    std::vector<unsigned int> renumber(vcount, EMPTY);
+    for (const auto idx : indices)
+        renumber[idx] = 0;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < vcount; i++)
+    {
+        if (renumber[i] == EMPTY)
+            continue;
+
+        renumber[i] = static_cast<unsigned int>(kept);
+        x[kept] = x[i];
+        y[kept] = y[i];
+        z[kept] = z[i];
+        kept++;
+    }
+
+    x.resize(kept);
+    y.resize(kept);
+    z.resize(kept);
+
+    for (auto &idx : indices)
+        idx = renumber[idx];
+
+    nodes.clear();
+    return vcount - kept;
 }
 
-// parse f
-bool Object::parse_face(const std::string &line, std::optional<int> current_material)
+Mesh Mesh::clustered(const float cell, float &displacement) const
 {
-    std::stringstream ss(line);
-    std::vector<unsigned int> local_indices;
+    // cluster coordinates take 12 bits per axis, vertex tag the low 17 bits
+    constexpr uint32_t BORDER = 0x10000;
+    constexpr uint32_t UNUSED = 0x20000;
+    constexpr uint64_t CELL_MAX = (1u << 12) - 1;
+
+    const size_t vcount = vertex_count();
+    const size_t fcount = face_count();
 
-    std::string token;
-    while (ss >> token)
+    displacement = 0.0f;
+
+    if (vcount == 0)
+    {
+        return {};
+    }
+
+    // material shared by all faces around vertex, BORDER if they differ
+    std::vector<uint32_t> tags(vcount, UNUSED);
+    for (size_t f = 0; f < fcount; f++)
     {
-        if (const auto slash_pos = token.find('/'); slash_pos != std::string::npos)
+        for (size_t k = 0; k < 3; k++)
         {
-            token.erase(slash_pos); // keep only first index
+            uint32_t &tag = tags[indices[3 * f + k]];
+            tag = (tag == UNUSED || tag == materials[f]) ? materials[f] : BORDER;
         }
+    }
 
-        auto maybe_idx = safe_stoi(token);
-        if (!maybe_idx)
+    const float x_min = *std::ranges::min_element(x);
+    const float y_min = *std::ranges::min_element(y);
+    const float z_min = *std::ranges::min_element(z);
+    const float inverse = 1.0f / cell;
+
+    auto cell_of = [&](const float value, const float low) {
+        return std::min(static_cast<uint64_t>((value - low) * inverse), CELL_MAX);
+    };
+
+    std::vector<std::pair<uint64_t, unsigned int>> keys;
+    keys.reserve(vcount);
+    for (size_t i = 0; i < vcount; i++)
+    {
+        if (tags[i] == UNUSED)
+            continue;
+
+        const uint64_t position = (cell_of(z[i], z_min) << 24) | (cell_of(y[i], y_min) << 12) | cell_of(x[i], x_min);
+        keys.emplace_back(position << 17 | tags[i], static_cast<unsigned int>(i));
+    }
+    std::ranges::sort(keys);
+
+    // each run of equal keys becomes one vertex at mean position
+    Mesh result;
+    std::vector<unsigned int> remap(vcount);
+    for (size_t begin = 0; begin < keys.size();)
+    {
+        size_t end = begin;
+        Vec3 sum(0.0f, 0.0f, 0.0f);
+        for (; end < keys.size() && keys[end].first == keys[begin].first; end++)
         {
-            std::cerr << "warning: invalid face token " << token << std::endl;
-            return false;
+            sum += vertex(keys[end].second);
+            remap[keys[end].second] = static_cast<unsigned int>(result.vertex_count());
         }
 
-        int ridx = relative_index(*maybe_idx, static_cast<int>(vertices.size()));
-        if (ridx < 0 || static_cast<size_t>(ridx) >= vertices.size())
+        const Vec3 mean = sum * (1.0f / static_cast<float>(end - begin));
+        for (size_t k = begin; k < end; k++)
         {
-            std::cerr << "warning: vertex index " << *maybe_idx << " out of range" << std::endl;
-            return false;
+            displacement = std::max(displacement, (vertex(keys[k].second) - mean).magnitude());
         }
-        local_indices.push_back(static_cast<unsigned int>(ridx));
+
+        result.add_vertex(mean);
+        begin = end;
     }
 
-    if (local_indices.size() < 3)
+    // faces with two corners in one cluster collapse
+    for (size_t f = 0; f < fcount; f++)
     {
-        std::cerr << "warning: face contains less than 3 indexes" << std::endl;
-        return false;
+        const unsigned int a = remap[indices[3 * f]];
+        const unsigned int b = remap[indices[3 * f + 1]];
+        const unsigned int c = remap[indices[3 * f + 2]];
+
+        if (a != b && b != c && a != c)
+        {
+            result.add_face(a, b, c, materials[f]);
+        }
     }
 
-    if (local_indices.size() == 3)
+    result.compute_normals();
+    return result;
+}
+
+void Mesh::build_bvh()
+{
+    nodes.clear();
+
+    const size_t fcount = face_count();
+    if (fcount == 0)
     {
-        faces.emplace_back(local_indices[0], local_indices[1], local_indices[2], current_material);
-        return true;
+        return;
     }
 
-    // triangularization
-    std::vector<Vec3> polygon;
-    polygon.reserve(local_indices.size());
+    // faces sorted along morton curve of centroids, tree halves consecutive ranges
+    const auto [x_min, x_max] = std::ranges::minmax(x);
+    const auto [y_min, y_max] = std::ranges::minmax(y);
+    const auto [z_min, z_max] = std::ranges::minmax(z);
+    const float scale = 1023.0f / std::max({x_max - x_min, y_max - y_min, z_max - z_min, 1e-6f});
+
+    // spreads 10 bits so that two zero bits follow each
+    auto spread_bits = [](uint64_t v) {
+        v = (v | (v << 16)) & 0x030000FFull;
+        v = (v | (v << 8)) & 0x0300F00Full;
+        v = (v | (v << 4)) & 0x030C30C3ull;
+        v = (v | (v << 2)) & 0x09249249ull;
+        return v;
+    };
+
+    std::vector<std::pair<uint64_t, unsigned int>> keys(fcount);
+    for (size_t f = 0; f < fcount; f++)
+    {
+        const unsigned int i1 = indices[3 * f], i2 = indices[3 * f + 1], i3 = indices[3 * f + 2];
+        const auto cell = [&](const std::vector<float> &axis, const float low) {
+            return static_cast<uint64_t>(((axis[i1] + axis[i2] + axis[i3]) * (1.0f / 3.0f) - low) * scale);
+        };
+
+        const uint64_t code = spread_bits(cell(x, x_min)) | spread_bits(cell(y, y_min)) << 1 | spread_bits(cell(z, z_min)) << 2;
+        keys[f] = {code << 32 | f, static_cast<unsigned int>(f)};
+    }
+    std::ranges::sort(keys);
+
+    std::vector<unsigned int> order(fcount);
+    for (size_t i = 0; i < fcount; i++)
+    {
+        order[i] = keys[i].second;
+    }
+
+    class Range {
+    public:
+        size_t node, begin, end;
+    };
+
+    nodes.reserve(2 * (fcount / BVH_LEAF_FACES + 1));
+    nodes.push_back({});
+
+    std::vector<Range> stack{{0, 0, fcount}};
+    while (!stack.empty())
+    {
+        const Range range = stack.back();
+        stack.pop_back();
 
-    for (const auto idx : local_indices)
+        if (range.end - range.begin <= BVH_LEAF_FACES)
+        {
+            nodes[range.node].first = static_cast<unsigned int>(range.begin);
+            nodes[range.node].count = static_cast<unsigned int>(range.end - range.begin);
+            continue;
+        }
+
+        const size_t mid = range.begin + (range.end - range.begin) / 2;
+        const size_t left = nodes.size();
+        nodes[range.node].first = static_cast<unsigned int>(left);
+        nodes[range.node].count = 0;
+        nodes.push_back({});
+        nodes.push_back({});
+
+        stack.push_back({left, range.begin, mid});
+        stack.push_back({left + 1, mid, range.end});
+    }
+
+    // faces in leaf order, light baked before stays valid
+    auto permute = [&](auto &values, const size_t stride) {
+        if (values.size() != fcount * stride)
+            return;
+
+        std::remove_reference_t<decltype(values)> sorted(values.size());
+        for (size_t i = 0; i < fcount; i++)
+        {
+            std::copy_n(values.begin() + static_cast<std::ptrdiff_t>(order[i] * stride), stride, sorted.begin() + static_cast<std::ptrdiff_t>(i * stride));
+        }
+        values.swap(sorted);
+    };
+
+    permute(indices, 3);
+    permute(materials, 1);
+    permute(nx, 1);
+    permute(ny, 1);
+    permute(nz, 1);
+    permute(luminance, 1);
+
+    // vertices in order of first use by sorted faces, gathers of neighbouring faces stay in cache
+    // unreferenced ones follow in old order, transform and bounds see same set
+    constexpr unsigned int UNSEEN = ~0u;
+    const size_t vcount = vertex_count();
+
+    std::vector<unsigned int> renumber(vcount, UNSEEN);
+    unsigned int next = 0;
+    for (auto &idx : indices)
     {
-        polygon.push_back(vertices[idx]);
+        if (renumber[idx] == UNSEEN)
+            renumber[idx] = next++;
+        idx = renumber[idx];
     }
 
-    const auto result = triangularize(polygon);
-    if (!result.has_value())
+    for (auto &target : renumber)
     {
-        std::cerr << "warning: triangularize failed" << std::endl;
+        if (target == UNSEEN)
+            target = next++;
+    }
+
+    for (auto *axis : {&x, &y, &z})
+    {
+        std::vector<float> moved(vcount);
+        for (size_t i = 0; i < vcount; i++)
+            moved[renumber[i]] = (*axis)[i];
+        axis->swap(moved);
+    }
+
+    // bounds and cones bottom up, children always follow their parent
+    constexpr float RIGHT_ANGLE = 1.57079632679f;
+    std::vector<float> spreads(nodes.size());
+
+    auto angle = [](const Vec3 &a, const Vec3 &b) {
+        return std::acos(std::clamp(Vec3::dot(a, b), -1.0f, 1.0f));
+    };
+
+    for (size_t n = nodes.size(); n-- > 0;)
+    {
+        BvhNode &node = nodes[n];
+        Vec3 low, high, axis;
+        float spread = 0.0f;
+
+        if (node.count > 0)
+        {
+            low = high = vertex(indices[3 * node.first]);
+
+            Vec3 sum(0.0f, 0.0f, 0.0f);
+            for (unsigned int k = 0; k < node.count; k++)
+            {
+                const size_t f = node.first + k;
+                for (size_t c = 0; c < 3; c++)
+                {
+                    const Vec3 v = vertex(indices[3 * f + c]);
+                    low = Vec3(std::min(low.x, v.x), std::min(low.y, v.y), std::min(low.z, v.z));
+                    high = Vec3(std::max(high.x, v.x), std::max(high.y, v.y), std::max(high.z, v.z));
+                }
+
+                sum += normal(f);
+            }
+
+            axis = sum.normalize();
+
+            // degenerate face has no direction and could be drawn from any side
+            float cosine = 1.0f;
+            for (size_t f = node.first; f < node.first + node.count; f++)
+            {
+                const Vec3 n = normal(f);
+                cosine = std::min(cosine, n.magnitude() < 0.5f ? -1.0f : Vec3::dot(axis, n));
+            }
+            spread = std::acos(std::clamp(cosine, -1.0f, 1.0f));
+        }
+        else
+        {
+            const BvhNode &a = nodes[node.first];
+            const BvhNode &b = nodes[node.first + 1];
+
+            low = Vec3(std::min(a.min[0], b.min[0]), std::min(a.min[1], b.min[1]), std::min(a.min[2], b.min[2]));
+            high = Vec3(std::max(a.max[0], b.max[0]), std::max(a.max[1], b.max[1]), std::max(a.max[2], b.max[2]));
+
+            const Vec3 axis_a(a.axis[0], a.axis[1], a.axis[2]);
+            const Vec3 axis_b(b.axis[0], b.axis[1], b.axis[2]);
+            axis = (axis_a + axis_b).normalize();
+            spread = std::max(angle(axis, axis_a) + spreads[node.first], angle(axis, axis_b) + spreads[node.first + 1]);
+        }
+
+        if (axis.magnitude() < 0.5f)
+        {
+            spread = RIGHT_ANGLE;
+        }
+
+        spreads[n] = spread;
+
+        node.min[0] = low.x;   node.min[1] = low.y;   node.min[2] = low.z;
+        node.max[0] = high.x;  node.max[1] = high.y;  node.max[2] = high.z;
+        node.axis[0] = axis.x; node.axis[1] = axis.y; node.axis[2] = axis.z;
+
+        // direction d sees only back faces when angle(axis, d) < 90 deg - spread
+        const float margin = spread + BVH_CONE_MARGIN;
+        node.cutoff = margin < RIGHT_ANGLE ? std::sin(margin) : 2.0f;
+    }
+}
+
+// Object methods
+
+// parse functions
+
+bool Object::validate() const
+{
+    if (mesh.vertex_count() == 0 || mesh.face_count() == 0)
+    {
+        std::cerr << "error: invalid object" << std::endl;
         return false;
     }
 
-    // adding faces
-    const auto &triangle_indices = result.value();
-    for (size_t i = 0; i < triangle_indices.size(); i += 3)
+    size_t n = mesh.vertex_count();
+    for (const auto idx : mesh.indices)
     {
-        unsigned int i1 = local_indices[ triangle_indices[i] ];
-        unsigned int i2 = local_indices[ triangle_indices[i+1] ];
-        unsigned int i3 = local_indices[ triangle_indices[i+2] ];
-        faces.emplace_back(i1, i2, i3, current_material);
+        if (idx >= n)
+        {
+            std::cerr << "error: invalid object" << std::endl;
+            return false;
+        }
     }
 
     return true;
 }
 
-// parse mtllib
-bool Object::parse_mtl_file(const std::string &line, const std::string &obj_filename)
+// parse whole chunk, stops at first invalid line
+void Object::parse_chunk(Chunk &chunk, const bool color_support)
 {
-    std::stringstream ss(line);
+    std::string_view text = chunk.text;
+    while (!text.empty())
+    {
+        const std::string_view line = next_line(text);
 
-    std::string mtl_filename;
-    ss >> mtl_filename;
-    if (mtl_filename.empty())
+        std::string_view cmd;
+        std::string_view arguments;
+        if (!split_command(line, cmd, arguments))
+        {
+            continue;
+        }
+
+        bool ok = true;
+
+        if (cmd == "v") // vertex
+        {
+            ok = parse_vertex(arguments, chunk);
+        }
+        else if (cmd == "f") // face
+        {
+            ok = parse_face(arguments, chunk);
+        }
+        else if (color_support && cmd == "mtllib")  // material file
+        {
+            chunk.commands.push_back({true, arguments, NO_MATERIAL});
+        }
+        else if (color_support && cmd == "usemtl")  // material
+        {
+            chunk.last_usemtl = static_cast<int>(chunk.commands.size());
+            chunk.commands.push_back({false, arguments, NO_MATERIAL});
+        }
+        // ignoring anything else
+
+        if (!ok)
+        {
+            chunk.ok = false;
+            return;
+        }
+    }
+}
+
+// parse v x y z
+bool Object::parse_vertex(std::string_view line, Chunk &chunk)
+{
+    const auto x = parse_float(next_token(line));
+    const auto y = parse_float(next_token(line));
+    const auto z = parse_float(next_token(line));
+
+    if (!x || !y || !z)
     {
-        std::cerr << "error: can't parse mtl filename" << std::endl;
+        std::cerr << "warning: invalid vertex format" << std::endl;
         return false;
     }
 
-    const auto parent = std::filesystem::path(obj_filename).parent_path();
-    const auto full_mtl_filename = parent / mtl_filename;
-    load_materials(full_mtl_filename.string());
+    chunk.part.add_vertex({*x, *y, *z});
     return true;
 }
 
-// parse usemtl
-std::optional<int> Object::parse_material(const std::string &line) const
+// parse f, indices are kept as written until vertex numbering of previous chunks is known
+bool Object::parse_face(std::string_view line, Chunk &chunk)
 {
-    std::stringstream ss(line);
+    const size_t first = chunk.tokens.size();
+
+    for (std::string_view token = next_token(line); !token.empty(); token = next_token(line))
+    {
+        if (const auto slash_pos = token.find('/'); slash_pos != std::string_view::npos)
+        {
+            token = token.substr(0, slash_pos); // keep only first index
+        }
+
+        auto maybe_idx = parse_int(token);
+        if (!maybe_idx)
+        {
+            std::cerr << "warning: invalid face token " << token << std::endl;
+            return false;
+        }
 
-    std::string material_name;
-    ss >> material_name;
+        chunk.tokens.push_back(*maybe_idx);
+    }
 
-    return find_material(material_name);
+    const auto count = static_cast<unsigned int>(chunk.tokens.size() - first);
+    chunk.raw_faces.push_back({first, count, static_cast<unsigned int>(chunk.part.vertex_count()), chunk.last_usemtl});
+    return true;
 }
 
-// parse newmtl
-bool Object::parse_current_material(const std::string &line, std::string &current_name, Vec3 &current_diffuse, bool &have_active_material)
+// resolve relative indices and triangulate faces of chunk
+bool Object::resolve_faces(Chunk &chunk) const
 {
-    if (have_active_material)
+    std::vector<unsigned int> local_indices; // reused between faces
+    std::vector<Vec3> polygon;
+    std::vector<unsigned int> triangles;
+    Triangulator triangulator;
+    chunk.part.indices.reserve(chunk.raw_faces.size() * 3);
+    chunk.part.materials.reserve(chunk.raw_faces.size());
+
+    for (const auto &raw : chunk.raw_faces)
     {
-        materials.emplace_back(current_name, current_diffuse);
+        const uint16_t current_material = raw.command < 0 ? chunk.initial_material : chunk.commands[raw.command].material;
+        const auto total_vertices = static_cast<int>(chunk.vertex_base + raw.vertices_before);
+
+        local_indices.clear();
+
+        for (unsigned int k = 0; k < raw.count; k++)
+        {
+            const int idx = chunk.tokens[raw.first + k];
+
+            int ridx = relative_index(idx, total_vertices);
+            if (ridx < 0 || ridx >= total_vertices)
+            {
+                std::cerr << "warning: vertex index " << idx << " out of range" << std::endl;
+                return false;
+            }
+            local_indices.push_back(static_cast<unsigned int>(ridx));
+        }
+
+        if (local_indices.size() < 3)
+        {
+            std::cerr << "warning: face contains less than 3 indexes" << std::endl;
+            return false;
+        }
+
+        if (local_indices.size() == 3)
+        {
+            chunk.part.add_face(local_indices[0], local_indices[1], local_indices[2], current_material);
+            continue;
+        }
+
+        // triangularization, buffers live for whole chunk
+        polygon.clear();
+        for (const auto idx : local_indices)
+        {
+            polygon.push_back(mesh.vertex(idx));
+        }
+
+        triangles.clear();
+        if (!triangulator.triangulate(polygon.data(), polygon.size(), triangles))
+        {
+            std::cerr << "warning: triangularize failed" << std::endl;
+            return false;
+        }
+
+        // adding faces
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            unsigned int i1 = local_indices[ triangles[i] ];
+            unsigned int i2 = local_indices[ triangles[i+1] ];
+            unsigned int i3 = local_indices[ triangles[i+2] ];
+            chunk.part.add_face(i1, i2, i3, current_material);
+        }
     }
 
-    if (std::stringstream ss(line); !(ss >> current_name))
-    {
-        std::cerr << "error: can't parse material name" << std::endl;
-        return false;
-    };
-    current_diffuse = Vec3(1.0f, 1.0f, 1.0f);
-    have_active_material = true;
     return true;
 }
 
-// parse kd
-bool Object::parse_diffuse_color(const std::string &line, Vec3 &current_diffuse)
+// path of mtllib argument, relative to obj file
+static std::string mtl_path(std::string_view line, const std::string &obj_filename)
 {
-    std::stringstream ss(line);
+    const std::string_view mtl_filename = next_token(line);
+    if (mtl_filename.empty())
+    {
+        return {};
+    }
+
+    return (std::filesystem::path(obj_filename).parent_path() / mtl_filename).string();
+}
 
-    float r, g, b;
-    if (!(ss >> r >> g >> b))
+// parse mtllib
+bool Object::parse_mtl_file(std::string_view line, const std::string &obj_filename, MaterialPrefetch &prefetch)
+{
+    const std::string mtl_filename = mtl_path(line, obj_filename);
+    if (mtl_filename.empty())
     {
-        std::cerr << "error: can't parse diffuse colors" << std::endl;
+        std::cerr << "error: can't parse mtl filename" << std::endl;
         return false;
     }
 
-    current_diffuse = Vec3(r, g, b);
+    load_materials(mtl_filename, prefetch);
     return true;
 }
 
+// parse usemtl
+std::optional<int> Object::parse_material(std::string_view line) const
+{
+    return find_material(next_token(line));
+}
+
 // methods
-bool Object::load(const std::string &obj_filename, bool color_support)
+bool Object::load(const std::string &obj_filename, bool color_support, const unsigned threads, const LoadObserver &observer)
 {
-    auto file = open_file(obj_filename);
-    if (!file)
+    MappedFile file;
+    if (!file.open(obj_filename))
     {
         return false;
     }
 
-    std::ifstream in = std::move(*file);
+    std::vector<Chunk> chunks;
+    for (const auto text : split_chunks(file.view(), LOAD_CHUNK_SIZE))
+    {
+        chunks.emplace_back().text = text;
+    }
+
+    // chunks go in waves in file order, without observer whole file is one wave
+    // faces refer only to vertices defined before them, so every wave is resolved against vertices of waves so far
+    const size_t wave_chunks = observer ? std::max<size_t>(LOAD_WAVE_CHUNKS, 2 * worker_count(threads)) : chunks.size();
+    const bool single_wave = wave_chunks >= chunks.size();
+
+    // libraries named in header before geometry are parsed on own threads while chunks parse
+    MaterialPrefetch prefetch;
+    if (color_support && !chunks.empty())
+    {
+        std::string_view text = chunks.front().text;
+        while (!text.empty())
+        {
+            std::string_view cmd;
+            std::string_view arguments;
+            if (!split_command(next_line(text), cmd, arguments))
+            {
+                continue;
+            }
+
+            if (cmd == "v" || cmd == "f")
+            {
+                break;
+            }
+
+            if (cmd == "mtllib")
+            {
+                if (const std::string mtl_filename = mtl_path(arguments, obj_filename); !mtl_filename.empty())
+                    prefetch.request(mtl_filename);
+            }
+        }
+    }
 
     std::optional<int> current_material = std::nullopt;
-    std::string line;
+    size_t total_vertices = 0;
+    size_t parsed_bytes = 0;
 
-    while (std::getline(in, line))
+    for (size_t first = 0; first < chunks.size(); first += wave_chunks)
     {
-        strip_line(line);
+        const size_t last = std::min(first + wave_chunks, chunks.size());
+        const std::span<Chunk> wave(chunks.data() + first, last - first);
 
-        if (line.empty() || line[0] == '#') // comment
+        // first pass - parse chunks independently
+        parallel_for(wave.size(), threads, [&](const size_t i) { parse_chunk(wave[i], color_support); });
+
+        if (!std::ranges::all_of(wave, &Chunk::ok))
         {
-            continue;
+            return false;
+        }
+
+        // second pass - in file order, vertex numbering and materials
+        size_t wave_vertices = 0;
+
+        for (auto &chunk : wave)
+        {
+            chunk.vertex_base = static_cast<unsigned int>(total_vertices);
+            chunk.initial_material = material_id(current_material);
+            total_vertices += chunk.part.vertex_count();
+            wave_vertices += chunk.part.vertex_count();
+
+            for (auto &command : chunk.commands)
+            {
+                if (command.library)
+                {
+                    if (!parse_mtl_file(command.argument, obj_filename, prefetch))
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+
+                current_material = parse_material(command.argument);
+                command.material = material_id(current_material);
+
+                if (!current_material)
+                {
+                    std::cerr << "warning: unknown material " << next_token(command.argument) << std::endl;
+                }
+            }
         }
 
-        std::stringstream ss(line);
-        std::string cmd;
-        ss >> cmd;
+        // later waves grow storage geometrically instead of exactly
+        if (single_wave)
+        {
+            mesh.x.reserve(mesh.x.size() + wave_vertices);
+            mesh.y.reserve(mesh.y.size() + wave_vertices);
+            mesh.z.reserve(mesh.z.size() + wave_vertices);
+        }
 
-        std::string arguments = line.substr(cmd.size());
-        if (!arguments.empty() && arguments[0] == ' ')
+        for (auto &chunk : wave)
         {
-            arguments.erase(0, 1);
+            mesh.x.insert(mesh.x.end(), chunk.part.x.begin(), chunk.part.x.end());
+            mesh.y.insert(mesh.y.end(), chunk.part.y.begin(), chunk.part.y.end());
+            mesh.z.insert(mesh.z.end(), chunk.part.z.begin(), chunk.part.z.end());
+
+            std::vector<float>().swap(chunk.part.x);
+            std::vector<float>().swap(chunk.part.y);
+            std::vector<float>().swap(chunk.part.z);
         }
 
-        bool ok = true;
+        // third pass - resolve faces against global vertices
+        parallel_for(wave.size(), threads, [&](const size_t i) { wave[i].ok = resolve_faces(wave[i]); });
 
-        if (cmd == "v") // vertex
+        if (!std::ranges::all_of(wave, &Chunk::ok))
         {
-            ok = parse_vertex(arguments);
+            return false;
         }
-        else if (cmd == "f") // face
+
+        size_t wave_faces = 0;
+        for (const auto &chunk : wave)
         {
-            ok = parse_face(arguments, current_material);
+            wave_faces += chunk.part.face_count();
         }
-        else if (color_support && cmd == "mtllib")  // material file
+
+        if (single_wave)
         {
-            ok = parse_mtl_file(arguments, obj_filename);
+            mesh.indices.reserve(mesh.indices.size() + wave_faces * 3);
+            mesh.materials.reserve(mesh.materials.size() + wave_faces);
         }
-        else if (color_support && cmd == "usemtl")  // material
+
+        for (auto &chunk : wave)
         {
-            current_material = parse_material(arguments);
+            mesh.indices.insert(mesh.indices.end(), chunk.part.indices.begin(), chunk.part.indices.end());
+            mesh.materials.insert(mesh.materials.end(), chunk.part.materials.begin(), chunk.part.materials.end());
+            parsed_bytes += chunk.text.size();
 
-            if (!current_material)
-            {
-                std::cerr << "warning: unknown material " << arguments << std::endl;
-            }
+            // parsed data of finished chunk is dropped
+            chunk = Chunk{};
         }
-        // ignoring anything else
 
-        if (!ok)
+        if (observer && !observer(*this, static_cast<float>(parsed_bytes) / static_cast<float>(file.size())))
         {
             return false;
         }
     }
 
-    in.close();
-    return validate();
-}
-
-bool Object::load_materials(const std::string &mtl_filename)
-{
-    auto file = open_file(mtl_filename);
-    if (!file.has_value())
+    if (!validate())
     {
         return false;
     }
 
-    std::ifstream in = std::move(*file);
+    // positions repeated per face group become one vertex, tolerance follows model size
+    const auto [x_min, x_max] = std::ranges::minmax(mesh.x);
+    const auto [y_min, y_max] = std::ranges::minmax(mesh.y);
+    const auto [z_min, z_max] = std::ranges::minmax(mesh.z);
+    mesh.weld(LOAD_WELD_TOLERANCE * std::max({x_max - x_min, y_max - y_min, z_max - z_min, 1e-6f}));
 
-    std::string current_name;
-    Vec3 current_diffuse(1.0f, 1.0f, 1.0f);
-    bool have_active_material = false;
-    std::string line;
-
-    while (std::getline(in, line))
+    // nothing left if all faces had no area
+    if (!validate())
     {
-        strip_line(line);
-
-        if (line.empty() || line[0] == '#') // comment
-            continue;
-
-        std::stringstream ss(line);
-        std::string cmd;
-        ss >> cmd;
+        return false;
+    }
 
-        std::string arguments = line.substr(cmd.size());
-        if (!arguments.empty() && arguments[0] == ' ')
-        {
-            arguments.erase(0, 1);
-        }
+    mesh.compute_normals();
+    return true;
+}
 
-        if (cmd == "newmtl") // current material
-        {
-            parse_current_material(arguments, current_name, current_diffuse, have_active_material);
-        }
-        else if (cmd == "Kd") // diffuse color
-        {
-            parse_diffuse_color(arguments, current_diffuse);
-        }
+bool Object::load_materials(const std::string &mtl_filename, MaterialPrefetch &prefetch)
+{
+    const auto library = prefetch.take(mtl_filename);
+    if (!library)
+    {
+        return false;
     }
 
-    if (have_active_material)
+    for (const auto &material : library->materials)
     {
-        materials.emplace_back(current_name, current_diffuse);
+        add_material(material.material_name, material.diffuse);
     }
 
     return true;
 }
 
+// redefinition keeps its own entry, lookup still resolves to first one
+void Object::add_material(const std::string &name, const Vec3 &diffuse)
+{
+    material_index.try_emplace(name, static_cast<int>(materials.size()));
+    materials.emplace_back(name, diffuse);
+}
+
 // find material by index
-std::optional<int> Object::find_material(const std::string &material_name) const
+std::optional<int> Object::find_material(const std::string_view material_name) const
 {
-    const auto it = std::ranges::find_if(materials, [&material_name](const Material &m){ return m.material_name == material_name; });
-    return (it != materials.end()) ? std::make_optional(std::distance(materials.begin(), it)) : std::nullopt;
+    const auto it = material_index.find(material_name);
+    return (it != material_index.end()) ? std::make_optional(it->second) : std::nullopt;
 }
 
 void Object::scale(float factor)
 {
-    for (auto &v : vertices)
+    lods.clear();
+    mesh.nodes.clear();
+
+    for (size_t i = 0; i < mesh.vertex_count(); i++)
     {
-        v *= factor;
+        mesh.x[i] *= factor;
+        mesh.y[i] *= factor;
+        mesh.z[i] *= factor;
     }
+
+    mesh.compute_normals();
+}
+
+size_t Object::vertex_count() const
+{
+    return stream ? stream->levels.front().vertex_count : mesh.vertex_count();
+}
+
+size_t Object::face_count() const
+{
+    return stream ? stream->levels.front().face_count : mesh.face_count();
 }
 
 // normalize verts of object
 void Object::normalize()
 {
-    if (vertices.empty())
+    lods.clear();
+    mesh.nodes.clear();
+
+    if (mesh.vertex_count() == 0)
     {
         return;
     }
 
-    Vec3 vmin = vertices[0];
-    Vec3 vmax = vertices[0];
-
-    for (const auto &v : vertices)
-    {
-        vmin.x = std::min(vmin.x, v.x);
-        vmin.y = std::min(vmin.y, v.y);
-        vmin.z = std::min(vmin.z, v.z);
+    const auto [x_min, x_max] = std::ranges::minmax(mesh.x);
+    const auto [y_min, y_max] = std::ranges::minmax(mesh.y);
+    const auto [z_min, z_max] = std::ranges::minmax(mesh.z);
 
-        vmax.x = std::max(vmax.x, v.x);
-        vmax.y = std::max(vmax.y, v.y);
-        vmax.z = std::max(vmax.z, v.z);
-    }
+    const Vec3 vmin(x_min, y_min, z_min);
+    const Vec3 vmax(x_max, y_max, z_max);
 
     const Vec3 center = (vmin + vmax) * 0.5f;
     const float scale = 1.0f / std::max({
@@ -378,25 +1034,45 @@ void Object::normalize()
         1e-6f
     });
 
-    for (auto &v : vertices)
+    for (size_t i = 0; i < mesh.vertex_count(); i++)
     {
-        v = (v - center) * scale;
+        mesh.x[i] = (mesh.x[i] - center.x) * scale;
+        mesh.y[i] = (mesh.y[i] - center.y) * scale;
+        mesh.z[i] = (mesh.z[i] - center.z) * scale;
     }
+
+    mesh.compute_normals();
 }
 
+// reversed winding turns normals around exactly
 void Object::flip_faces()
 {
-    for (auto &f : faces)
+    lods.clear();
+    mesh.nodes.clear();
+    mesh.luminance.clear();
+
+    for (size_t f = 0; f < mesh.face_count(); f++)
     {
-        std::swap(f.indices[1], f.indices[2]);
+        std::swap(mesh.indices[3 * f + 1], mesh.indices[3 * f + 2]);
+
+        mesh.nx[f] = -mesh.nx[f];
+        mesh.ny[f] = -mesh.ny[f];
+        mesh.nz[f] = -mesh.nz[f];
     }
 }
 
+// mirrored axis keeps normal component along it and negates others, fixed winding negates them all
 void Object::invert_x()
 {
-    for (auto &v : vertices)
+    for (size_t i = 0; i < mesh.vertex_count(); i++)
+    {
+        mesh.x[i] = -mesh.x[i];
+    }
+
+    for (size_t f = 0; f < mesh.face_count(); f++)
     {
-        v.x = -v.x;
+        mesh.ny[f] = -mesh.ny[f];
+        mesh.nz[f] = -mesh.nz[f];
     }
 
     flip_faces();
@@ -404,9 +1080,15 @@ void Object::invert_x()
 
 void Object::invert_y()
 {
-    for (auto &v : vertices)
+    for (size_t i = 0; i < mesh.vertex_count(); i++)
+    {
+        mesh.y[i] = -mesh.y[i];
+    }
+
+    for (size_t f = 0; f < mesh.face_count(); f++)
     {
-        v.y = -v.y;
+        mesh.nx[f] = -mesh.nx[f];
+        mesh.nz[f] = -mesh.nz[f];
     }
 
     flip_faces();
@@ -415,10 +1097,71 @@ void Object::invert_y()
 
 void Object::invert_z()
 {
-    for (auto &v : vertices)
+    for (size_t i = 0; i < mesh.vertex_count(); i++)
+    {
+        mesh.z[i] = -mesh.z[i];
+    }
+
+    for (size_t f = 0; f < mesh.face_count(); f++)
     {
-        v.z = -v.z;
+        mesh.nx[f] = -mesh.nx[f];
+        mesh.ny[f] = -mesh.ny[f];
     }
 
     flip_faces();
 }
+
+// every level clusters previous one on twice coarser grid, so errors add up along chain
+void Object::build_lods()
+{
+    lods.clear();
+
+    if (mesh.face_count() < LOD_MIN_FACES)
+    {
+        return;
+    }
+
+    const auto [x_min, x_max] = std::ranges::minmax(mesh.x);
+    const auto [y_min, y_max] = std::ranges::minmax(mesh.y);
+    const auto [z_min, z_max] = std::ranges::minmax(mesh.z);
+    const float extent = std::max({x_max - x_min, y_max - y_min, z_max - z_min, 1e-6f});
+
+    // levels are kept in place, source must not move while next one is built
+    unsigned int levels = 0;
+    for (unsigned int grid = LOD_GRID_MAX; grid >= LOD_GRID_MIN; grid /= 2)
+        levels++;
+    lods.reserve(levels);
+
+    const Mesh *source = &mesh;
+    float source_error = 0.0f;
+
+    for (unsigned int grid = LOD_GRID_MAX; grid >= LOD_GRID_MIN; grid /= 2)
+    {
+        float displacement;
+        Mesh level = source->clustered(extent / static_cast<float>(grid), displacement);
+
+        if (level.face_count() == 0)
+        {
+            break;
+        }
+
+        if (static_cast<float>(level.face_count()) > LOD_MIN_REDUCTION * static_cast<float>(source->face_count()))
+        {
+            continue;
+        }
+
+        source_error += displacement;
+        lods.push_back({std::move(level), source_error});
+        source = &lods.back().mesh;
+    }
+}
+
+void Object::build_bvh()
+{
+    mesh.build_bvh();
+
+    for (auto &lod : lods)
+    {
+        lod.mesh.build_bvh();
+    }
+}
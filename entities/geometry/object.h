@@ -4,28 +4,81 @@
 
 #pragma once
 
-#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 #include <algorithm>
 #include <cctype>
 #include <cstring>
 
 #include "utils/algorithms.h"
+#include "utils/files.h"
+#include "utils/parallel.h"
 #include "utils/tools.h"
+#include "config.h"
 
-// triangular face
-class Face {
+// face without material
+inline constexpr uint16_t NO_MATERIAL = 0xFFFF;
+
+// node of bounding volume hierarchy over faces of mesh
+class BvhNode {
+public:
+    float min[3], max[3];   // bounding box of faces in object space
+    float axis[3];          // axis of cone around face normals, unit or zero
+    float cutoff;           // every face looks away from unit direction d when dot(axis, d) > cutoff
+    unsigned int first;     // leaf - first face, inner node - first of two adjacent children
+    unsigned int count;     // leaf - number of faces, 0 for inner node
+};
+
+// triangle mesh in structure of arrays layout
+class Mesh {
 public:
-    std::array<unsigned int, 3> indices;    // indices of vertices
-    std::optional<int> material;            // index of material
+    std::vector<float> x, y, z;             // vertex coordinates
+
+    std::vector<unsigned int> indices;      // vertex indices, 3 per face
+    std::vector<uint16_t> materials;        // material index per face or NO_MATERIAL
+    std::vector<float> nx, ny, nz;          // unit face normal in object space
+    std::vector<char> luminance;            // baked static light character per face, empty if not baked
+    std::vector<BvhNode> nodes;             // hierarchy over faces with root first, empty if not built
+
+    [[nodiscard]] size_t vertex_count() const { return x.size(); }
+    [[nodiscard]] size_t face_count() const { return materials.size(); }
+
+    [[nodiscard]] Vec3 vertex(const size_t i) const { return {x[i], y[i], z[i]}; }
+    [[nodiscard]] Vec3 normal(const size_t f) const { return {nx[f], ny[f], nz[f]}; }
+
+    void add_vertex(const Vec3 &v);
+    void add_face(unsigned int idx1, unsigned int idx2, unsigned int idx3, uint16_t material = NO_MATERIAL);
+
+    void compute_normals(); // face normals from current vertices, drops baked luminance
+
+    // merges vertices closer than tolerance into first of them, drops faces left without area and unreferenced vertices
+    // returns number of removed vertices
+    size_t weld(float tolerance);
+
+    // mesh with vertices merged per grid cell of given size, vertices on material borders merge only among themselves,
+    // displacement is set to largest distance of vertex from its merged position
+    [[nodiscard]] Mesh clustered(float cell, float &displacement) const;
 
-    Face(const unsigned int idx1, const unsigned int idx2, const unsigned int idx3, const std::optional<int> mat = std::nullopt) : indices{idx1, idx2, idx3}, material(mat) {}
+    // builds nodes, reorders faces so that leaves cover consecutive face ranges in depth first order
+    // and vertices in order of first use by reordered faces
+    void build_bvh();
+};
+
+// simplified mesh with its geometric error
+class LodLevel {
+public:
+    Mesh mesh;
+    float error;    // largest vertex displacement from source mesh in object space
 };
 
 // material properties
@@ -37,17 +90,30 @@ public:
     Material(const std::string &name, const Vec3 &color) : material_name(name), diffuse(color) {}
 };
 
+class Object;
+class ClusterFile;
+class MaterialPrefetch;
+
+// called after every load wave with object parsed so far (faces without normals) and fraction of file done, false cancels loading
+using LoadObserver = std::function<bool(const Object &partial, float progress)>;
+
 // object (3d model)
 class Object {
 public:
     Object() = default;
 
-    std::vector<Vec3> vertices;
-    std::vector<Face> faces;
+    Mesh mesh;
     std::vector<Material> materials;
+    std::vector<LodLevel> lods;     // simplified meshes from finest to coarsest, empty if not built
+    std::shared_ptr<const ClusterFile> stream;  // levels paged from clustered sidecar, mesh and lods are empty then
 
-    // load obj file with optional material mtl support
-    bool load(const std::string &obj_filename, bool color_support = false);
+    // of full mesh, resident or streamed
+    [[nodiscard]] size_t vertex_count() const;
+    [[nodiscard]] size_t face_count() const;
+
+    // load obj file with optional material mtl support, parsed in parallel by given number of threads (0 - all cores)
+    // with observer file is parsed in waves of chunks and observer sees every finished prefix
+    bool load(const std::string &obj_filename, bool color_support = false, unsigned threads = 0, const LoadObserver &observer = {});
 
 
     void normalize();           // normalize object
@@ -58,18 +124,37 @@ public:
     void invert_y();
     void invert_z();
 
+    // simplified meshes of current geometry, transforms above drop them
+    void build_lods();
+
+    // hierarchies of mesh and its simplified levels, transforms above drop them
+    void build_bvh();
+
 private:
+    // hashing of names for lookup by string_view without temporary string
+    class NameHash {
+    public:
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    // material name to index in materials, first definition of name wins
+    std::unordered_map<std::string, int, NameHash, std::equal_to<>> material_index;
+
     // material related methods
-    bool load_materials(const std::string &mtl_filename);
-    std::optional<int> find_material(const std::string &material_name) const;
-
-    // composite methods of parser
-    bool parse_vertex(const std::string &line);
-    bool parse_face(const std::string &line, std::optional<int> current_material);
-    bool parse_mtl_file(const std::string &line, const std::string &obj_filename);
-    std::optional<int> parse_material(const std::string &line) const;
-    bool parse_current_material(const std::string &line, std::string &current_name, Vec3 &current_diffuse, bool &have_active_material);
-    static bool parse_diffuse_color(const std::string &line, Vec3 &current_diffuse);
+    bool load_materials(const std::string &mtl_filename, MaterialPrefetch &prefetch);
+    void add_material(const std::string &name, const Vec3 &diffuse);
+    std::optional<int> find_material(std::string_view material_name) const;
+
+    class Chunk; // part of obj file parsed independently
+
+    // composite methods of parser, lines are views into mapped file
+    static void parse_chunk(Chunk &chunk, bool color_support);
+    static bool parse_vertex(std::string_view line, Chunk &chunk);
+    static bool parse_face(std::string_view line, Chunk &chunk);
+    bool resolve_faces(Chunk &chunk) const;
+    bool parse_mtl_file(std::string_view line, const std::string &obj_filename, MaterialPrefetch &prefetch);
+    std::optional<int> parse_material(std::string_view line) const;
 
     // validation of object after parsing
     bool validate() const;
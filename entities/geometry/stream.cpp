@@ -0,0 +1,566 @@
+/*
+ * stream.cpp
+ */
+
+#include "stream.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/mman.h>
+
+#include "cache.h"
+
+// layout of sidecar:
+// header | levels | clusters | hull x, y, z float[hull_count] | material table | padding | cluster data blocks
+// material table entry as in .objc, every data block starts at multiple of STREAM_BLOCK_ALIGN
+
+static constexpr char STREAM_MAGIC[4] = {'O', 'B', 'J', 'S'};
+static constexpr uint32_t STREAM_VERSION = 2;
+
+class StreamHeader {
+public:
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t flags;
+    uint32_t level_count;
+    uint32_t cluster_count;
+    uint32_t material_count;
+    uint32_t hull_count;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(StreamHeader) == 48, "sidecar header must stay packed");
+static_assert(sizeof(ClusterLevel) == 32, "level record must stay packed");
+static_assert(sizeof(ClusterRecord) == 56, "cluster record must stay packed");
+
+static size_t align_block(const size_t pos)
+{
+    return (pos + STREAM_BLOCK_ALIGN - 1) / STREAM_BLOCK_ALIGN * STREAM_BLOCK_ALIGN;
+}
+
+size_t ClusterRecord::bytes() const
+{
+    return static_cast<size_t>(vertex_count) * 3 * sizeof(float)
+         + static_cast<size_t>(face_count) * (3 * sizeof(float) + 3 * sizeof(unsigned int) + sizeof(uint16_t));
+}
+
+// faces of one cluster with vertices renumbered in order of first use
+class ClusterData {
+public:
+    std::vector<float> x, y, z;
+    std::vector<unsigned int> indices;
+
+    // gathers faces [begin, end) of mesh, local maps mesh vertex to cluster vertex and is left all NONE
+    void gather(const Mesh &mesh, const size_t begin, const size_t end, std::vector<unsigned int> &local)
+    {
+        constexpr unsigned int NONE = ~0u;
+
+        x.clear();
+        y.clear();
+        z.clear();
+        indices.clear();
+
+        for (size_t i = 3 * begin; i < 3 * end; i++)
+        {
+            const unsigned int idx = mesh.indices[i];
+            if (local[idx] == NONE)
+            {
+                local[idx] = static_cast<unsigned int>(x.size());
+                x.push_back(mesh.x[idx]);
+                y.push_back(mesh.y[idx]);
+                z.push_back(mesh.z[idx]);
+            }
+            indices.push_back(local[idx]);
+        }
+
+        for (size_t i = 3 * begin; i < 3 * end; i++)
+            local[mesh.indices[i]] = NONE;
+    }
+};
+
+// face range and hierarchy node of cluster before it is written
+class Piece {
+public:
+    const Mesh *mesh;
+    size_t begin, end;
+    const BvhNode *node;    // nullptr when mesh has no hierarchy
+};
+
+// cuts mesh into subtrees of hierarchy with at most STREAM_CLUSTER_FACES faces, consecutive ranges without it
+static void cut(const Mesh &mesh, std::vector<Piece> &pieces)
+{
+    const size_t fcount = mesh.face_count();
+
+    if (mesh.nodes.empty())
+    {
+        for (size_t begin = 0; begin < fcount; begin += STREAM_CLUSTER_FACES)
+            pieces.push_back({&mesh, begin, std::min(begin + STREAM_CLUSTER_FACES, fcount), nullptr});
+        return;
+    }
+
+    // face ranges of subtrees, children always follow their parent and cover adjacent ranges
+    std::vector<std::pair<size_t, size_t>> ranges(mesh.nodes.size());
+    for (size_t n = mesh.nodes.size(); n-- > 0;)
+    {
+        const BvhNode &node = mesh.nodes[n];
+        ranges[n] = node.count > 0 ? std::pair<size_t, size_t>{node.first, node.first + node.count}
+                                   : std::pair<size_t, size_t>{ranges[node.first].first, ranges[node.first + 1].second};
+    }
+
+    std::vector<unsigned int> stack{0};
+    while (!stack.empty())
+    {
+        const unsigned int n = stack.back();
+        stack.pop_back();
+
+        const BvhNode &node = mesh.nodes[n];
+        const auto [begin, end] = ranges[n];
+
+        if (node.count > 0 || end - begin <= STREAM_CLUSTER_FACES)
+        {
+            pieces.push_back({&mesh, begin, end, &node});
+            continue;
+        }
+
+        stack.push_back(node.first + 1);
+        stack.push_back(node.first);
+    }
+}
+
+std::filesystem::path ClusterFile::path_for(const std::string &obj_filename)
+{
+    return std::filesystem::path(obj_filename).replace_extension(".objs");
+}
+
+bool ClusterFile::save(const Object &obj, const std::string &obj_filename, const uint32_t flags)
+{
+    MeshCache::Source source;
+    if (!MeshCache::Source::stat(obj_filename, source) || obj.mesh.face_count() == 0)
+    {
+        return false;
+    }
+
+    const auto stream_filename = path_for(obj_filename);
+    // levels finest first, full mesh has no error
+    std::vector<const Mesh *> meshes{&obj.mesh};
+    std::vector<float> errors{0.0f};
+    for (const auto &lod : obj.lods)
+    {
+        meshes.push_back(&lod.mesh);
+        errors.push_back(lod.error);
+    }
+
+    std::vector<Piece> pieces;
+    std::vector<ClusterLevel> levels;
+    for (size_t l = 0; l < meshes.size(); l++)
+    {
+        ClusterLevel level{};
+        level.error = errors[l];
+        level.first = static_cast<uint32_t>(pieces.size());
+        cut(*meshes[l], pieces);
+        level.count = static_cast<uint32_t>(pieces.size() - level.first);
+        levels.push_back(level);
+    }
+
+    // first pass - bounds and sizes of clusters
+    size_t vcount = 0;
+    for (const Mesh *mesh : meshes)
+        vcount = std::max(vcount, mesh->vertex_count());
+
+    std::vector<unsigned int> local(vcount, ~0u);
+    ClusterData data;
+
+    std::vector<ClusterRecord> records(pieces.size());
+    for (size_t c = 0; c < pieces.size(); c++)
+    {
+        const Piece &piece = pieces[c];
+        ClusterRecord &record = records[c];
+        data.gather(*piece.mesh, piece.begin, piece.end, local);
+
+        const auto [x_min, x_max] = std::ranges::minmax(data.x);
+        const auto [y_min, y_max] = std::ranges::minmax(data.y);
+        const auto [z_min, z_max] = std::ranges::minmax(data.z);
+        record.min[0] = x_min;
+        record.min[1] = y_min;
+        record.min[2] = z_min;
+        record.max[0] = x_max;
+        record.max[1] = y_max;
+        record.max[2] = z_max;
+
+        // cone of subtree root, chunks without hierarchy are never culled by it
+        if (piece.node)
+        {
+            std::copy_n(piece.node->axis, 3, record.axis);
+            record.cutoff = piece.node->cutoff;
+        }
+        else
+        {
+            std::fill_n(record.axis, 3, 0.0f);
+            record.cutoff = 1.0f;
+        }
+
+        record.vertex_count = static_cast<uint32_t>(data.x.size());
+        record.face_count = static_cast<uint32_t>(piece.end - piece.begin);
+    }
+
+    for (size_t l = 0; l < levels.size(); l++)
+    {
+        for (uint32_t c = levels[l].first; c < levels[l].first + levels[l].count; c++)
+        {
+            levels[l].vertex_count += records[c].vertex_count;
+            levels[l].face_count += records[c].face_count;
+        }
+    }
+
+    // hull - coarsest level if small enough, bounding box corners otherwise
+    std::vector<float> hull_x, hull_y, hull_z;
+    const Mesh &coarsest = *meshes.back();
+    if (coarsest.vertex_count() <= STREAM_HULL_VERTICES)
+    {
+        hull_x = coarsest.x;
+        hull_y = coarsest.y;
+        hull_z = coarsest.z;
+    }
+    else
+    {
+        const auto [x_min, x_max] = std::ranges::minmax(obj.mesh.x);
+        const auto [y_min, y_max] = std::ranges::minmax(obj.mesh.y);
+        const auto [z_min, z_max] = std::ranges::minmax(obj.mesh.z);
+
+        for (int corner = 0; corner < 8; corner++)
+        {
+            hull_x.push_back(corner & 1 ? x_max : x_min);
+            hull_y.push_back(corner & 2 ? y_max : y_min);
+            hull_z.push_back(corner & 4 ? z_max : z_min);
+        }
+    }
+
+    // offsets of data blocks after tables
+    size_t pos = sizeof(StreamHeader) + levels.size() * sizeof(ClusterLevel) + records.size() * sizeof(ClusterRecord) + 3 * hull_x.size() * sizeof(float);
+    for (const auto &material : obj.materials)
+        pos += sizeof(uint32_t) + material.material_name.size() + 3 * sizeof(float);
+
+    for (auto &record : records)
+    {
+        record.offset = align_block(pos);
+        pos = record.offset + record.bytes();
+    }
+
+    // own temp file, truncating it never shrinks sidecar another process has mapped
+    const auto temp_filename = unique_temp(stream_filename);
+    if (temp_filename.empty())
+    {
+        std::cerr << "warning: can't write stream " << stream_filename.string() << std::endl;
+        return false;
+    }
+
+    std::ofstream out(temp_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "warning: can't write stream " << stream_filename.string() << std::endl;
+        std::filesystem::remove(temp_filename);
+        return false;
+    }
+
+    StreamHeader header{};
+    std::memcpy(header.magic, STREAM_MAGIC, sizeof(STREAM_MAGIC));
+    header.version = STREAM_VERSION;
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+    header.flags = flags;
+    header.level_count = static_cast<uint32_t>(levels.size());
+    header.cluster_count = static_cast<uint32_t>(records.size());
+    header.material_count = static_cast<uint32_t>(obj.materials.size());
+    header.hull_count = static_cast<uint32_t>(hull_x.size());
+
+    size_t written = 0;
+    auto write = [&](const void *bytes, const size_t size) {
+        out.write(static_cast<const char *>(bytes), static_cast<std::streamsize>(size));
+        written += size;
+    };
+
+    write(&header, sizeof(header));
+    write(levels.data(), levels.size() * sizeof(ClusterLevel));
+    write(records.data(), records.size() * sizeof(ClusterRecord));
+    write(hull_x.data(), hull_x.size() * sizeof(float));
+    write(hull_y.data(), hull_y.size() * sizeof(float));
+    write(hull_z.data(), hull_z.size() * sizeof(float));
+
+    for (const auto &material : obj.materials)
+    {
+        const auto length = static_cast<uint32_t>(material.material_name.size());
+        const float diffuse[3] = {material.diffuse.x, material.diffuse.y, material.diffuse.z};
+
+        write(&length, sizeof(length));
+        write(material.material_name.data(), length);
+        write(diffuse, sizeof(diffuse));
+    }
+
+    // second pass - cluster data, gathered again instead of keeping whole copy of every level
+    const std::vector<char> zeros(STREAM_BLOCK_ALIGN, 0);
+    for (size_t c = 0; c < pieces.size() && out; c++)
+    {
+        const Piece &piece = pieces[c];
+        const Mesh &mesh = *piece.mesh;
+        const size_t fcount = piece.end - piece.begin;
+        data.gather(mesh, piece.begin, piece.end, local);
+
+        write(zeros.data(), records[c].offset - written);
+        write(data.x.data(), data.x.size() * sizeof(float));
+        write(data.y.data(), data.y.size() * sizeof(float));
+        write(data.z.data(), data.z.size() * sizeof(float));
+        write(mesh.nx.data() + piece.begin, fcount * sizeof(float));
+        write(mesh.ny.data() + piece.begin, fcount * sizeof(float));
+        write(mesh.nz.data() + piece.begin, fcount * sizeof(float));
+        write(data.indices.data(), data.indices.size() * sizeof(unsigned int));
+        write(mesh.materials.data() + piece.begin, fcount * sizeof(uint16_t));
+    }
+
+    out.close();
+    if (!out)
+    {
+        std::cerr << "warning: can't write stream " << stream_filename.string() << std::endl;
+        std::filesystem::remove(temp_filename);
+        return false;
+    }
+
+    // replace atomically, readers never see half written sidecar and keep mapping of one they opened
+    std::error_code ec;
+    std::filesystem::rename(temp_filename, stream_filename, ec);
+    if (ec)
+    {
+        std::cerr << "warning: can't write stream " << stream_filename.string() << std::endl;
+        std::filesystem::remove(temp_filename, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool ClusterFile::load(Object &obj, const std::string &obj_filename, const uint32_t flags, const size_t budget)
+{
+    MeshCache::Source source;
+    if (!MeshCache::Source::stat(obj_filename, source))
+    {
+        return false;
+    }
+
+    const auto stream_filename = path_for(obj_filename);
+    if (!std::filesystem::exists(stream_filename))
+    {
+        return false;
+    }
+
+    auto stream = std::make_shared<ClusterFile>();
+    if (!stream->file.open(stream_filename.string()))
+    {
+        return false;
+    }
+
+    BoundedReader reader(stream->file.view());
+
+    StreamHeader header{};
+    if (!reader.read(&header, sizeof(header)) || std::memcmp(header.magic, STREAM_MAGIC, sizeof(STREAM_MAGIC)) != 0 || header.version != STREAM_VERSION
+        || header.level_count == 0 || header.cluster_count == 0 || header.hull_count == 0)
+    {
+        std::cerr << "warning: ignoring invalid stream " << stream_filename.string() << std::endl;
+        return false;
+    }
+
+    // stale or written with other transforms
+    if (header.source_size != source.size || header.source_mtime != source.mtime || header.flags != flags)
+    {
+        return false;
+    }
+
+    stream->levels.resize(header.level_count);
+    stream->clusters.resize(header.cluster_count);
+    stream->hull_x.resize(header.hull_count);
+    stream->hull_y.resize(header.hull_count);
+    stream->hull_z.resize(header.hull_count);
+
+    bool ok = reader.read(stream->levels.data(), stream->levels.size() * sizeof(ClusterLevel))
+           && reader.read(stream->clusters.data(), stream->clusters.size() * sizeof(ClusterRecord))
+           && reader.read(stream->hull_x.data(), stream->hull_x.size() * sizeof(float))
+           && reader.read(stream->hull_y.data(), stream->hull_y.size() * sizeof(float))
+           && reader.read(stream->hull_z.data(), stream->hull_z.size() * sizeof(float));
+
+    std::vector<Material> materials;
+    for (uint32_t i = 0; ok && i < header.material_count; i++)
+    {
+        uint32_t length = 0;
+        std::string name;
+        float diffuse[3];
+
+        ok = reader.read(&length, sizeof(length)) && reader.read_string(name, length) && reader.read(diffuse, sizeof(diffuse));
+        if (ok)
+        {
+            materials.emplace_back(name, Vec3(diffuse[0], diffuse[1], diffuse[2]));
+        }
+    }
+
+    // tables only, cluster data is checked on first use so that opening does not read whole file
+    const size_t size = stream->file.size();
+    ok = ok && std::ranges::all_of(stream->levels, [&](const ClusterLevel &level) {
+        return level.count > 0 && level.first <= header.cluster_count && level.count <= header.cluster_count - level.first;
+    });
+    ok = ok && std::ranges::all_of(stream->clusters, [&](const ClusterRecord &record) {
+        return record.face_count > 0 && record.vertex_count > 0 && record.offset % STREAM_BLOCK_ALIGN == 0
+            && record.offset >= reader.position() && record.offset <= size && record.bytes() <= size - record.offset;
+    });
+
+    if (!ok)
+    {
+        std::cerr << "warning: ignoring invalid stream " << stream_filename.string() << std::endl;
+        return false;
+    }
+
+    for (const auto &record : stream->clusters)
+        stream->max_vertices = std::max<size_t>(stream->max_vertices, record.vertex_count);
+
+    // clusters are read in view order, read ahead would only pull in clusters nobody asked for
+    stream->file.advise(0, size, MADV_RANDOM);
+
+    // clusters sharing a page would be dropped together with their neighbours, budget is then not kept
+    stream->paged = STREAM_BLOCK_ALIGN % MappedFile::page_size() == 0;
+    if (!stream->paged)
+    {
+        std::cerr << "warning: page size " << MappedFile::page_size() << " exceeds cluster alignment, streamed model is not paged out" << std::endl;
+    }
+
+    stream->budget = budget;
+    stream->material_count = header.material_count;
+    stream->state.assign(header.cluster_count, 0);
+    stream->newer.assign(header.cluster_count, NONE);
+    stream->older.assign(header.cluster_count, NONE);
+
+    Object loaded;
+    loaded.materials = std::move(materials);
+    loaded.stream = std::move(stream);
+
+    obj = std::move(loaded);
+    return true;
+}
+
+size_t ClusterFile::span(const unsigned int cluster) const
+{
+    return align_block(clusters[cluster].bytes());
+}
+
+void ClusterFile::unlink(const unsigned int cluster) const
+{
+    const unsigned int before = newer[cluster], after = older[cluster];
+
+    (before == NONE ? newest : older[before]) = after;
+    (after == NONE ? oldest : newer[after]) = before;
+    newer[cluster] = older[cluster] = NONE;
+}
+
+void ClusterFile::link_newest(const unsigned int cluster) const
+{
+    older[cluster] = newest;
+    (newest == NONE ? oldest : newer[newest]) = cluster;
+    newest = cluster;
+}
+
+bool ClusterFile::validate(const ClusterRecord &record) const
+{
+    const char *block = file.data() + record.offset;
+    const size_t faces = record.face_count;
+
+    const auto *indices = reinterpret_cast<const unsigned int *>(block + (static_cast<size_t>(record.vertex_count) * 3 + faces * 3) * sizeof(float));
+    const auto *materials = reinterpret_cast<const uint16_t *>(indices + 3 * faces);
+
+    const bool valid_indices = std::all_of(indices, indices + 3 * faces, [&](const unsigned int idx) { return idx < record.vertex_count; });
+    const bool valid_materials = std::all_of(materials, materials + faces, [&](const uint16_t m) { return m == NO_MATERIAL || m < material_count; });
+    return valid_indices && valid_materials;
+}
+
+void ClusterFile::prefetch(const std::span<const unsigned int> order) const
+{
+    std::lock_guard lock(mutex);
+
+    size_t requested = 0;
+    for (const unsigned int c : order)
+    {
+        if (!paged)
+            break;
+
+        if (state[c] & RESIDENT)
+            continue;
+
+        requested += span(c);
+        if (resident_bytes + requested > budget)
+            break;
+
+        file.advise(clusters[c].offset, clusters[c].bytes(), MADV_WILLNEED);
+    }
+}
+
+bool ClusterFile::acquire(const unsigned int cluster, ClusterView &view) const
+{
+    const ClusterRecord &record = clusters[cluster];
+
+    {
+        std::lock_guard lock(mutex);
+        uint8_t &flags = state[cluster];
+
+        if (flags & RESIDENT)
+        {
+            unlink(cluster);
+            link_newest(cluster);
+        }
+        else
+        {
+            flags |= RESIDENT;
+            resident_bytes += span(cluster);
+            link_newest(cluster);
+
+            // oldest first, cluster being acquired stays even if it alone is over budget
+            while (paged && resident_bytes > budget && oldest != cluster)
+            {
+                const unsigned int victim = oldest;
+                file.advise(clusters[victim].offset, clusters[victim].bytes(), MADV_DONTNEED);
+                state[victim] &= static_cast<uint8_t>(~RESIDENT);
+                resident_bytes -= span(victim);
+                unlink(victim);
+            }
+        }
+
+        if (!(flags & CHECKED))
+        {
+            flags |= CHECKED | (validate(record) ? 0 : INVALID);
+            if (flags & INVALID)
+                std::cerr << "warning: skipping invalid cluster " << cluster << " of stream" << std::endl;
+        }
+
+        if (flags & INVALID)
+            return false;
+    }
+
+    const char *block = file.data() + record.offset;
+    const size_t vertices = record.vertex_count, faces = record.face_count;
+    const auto *floats = reinterpret_cast<const float *>(block);
+
+    view.x = floats;
+    view.y = floats + vertices;
+    view.z = floats + 2 * vertices;
+    view.nx = floats + 3 * vertices;
+    view.ny = view.nx + faces;
+    view.nz = view.ny + faces;
+    view.indices = reinterpret_cast<const unsigned int *>(view.nz + faces);
+    view.materials = reinterpret_cast<const uint16_t *>(view.indices + 3 * faces);
+    view.vertices = vertices;
+    view.faces = faces;
+    return true;
+}
+
+size_t ClusterFile::resident() const
+{
+    std::lock_guard lock(mutex);
+    return resident_bytes;
+}
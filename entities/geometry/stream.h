@@ -0,0 +1,115 @@
+/*
+ * stream.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "object.h"
+#include "utils/files.h"
+
+// bounds and normal cone of cluster like BvhNode, data block is page aligned
+class ClusterRecord {
+public:
+    float min[3], max[3];   // bounding box in object space
+    float axis[3];          // normal cone, zero axis never culls
+    float cutoff;
+    uint64_t offset;        // data block: x, y, z, nx, ny, nz float | indices uint32[3 * faces] | materials uint16
+    uint32_t vertex_count;
+    uint32_t face_count;
+
+    [[nodiscard]] size_t bytes() const;     // size of data block without alignment padding
+};
+
+// consecutive clusters of one level of detail
+class ClusterLevel {
+public:
+    float error;            // as LodLevel::error, 0 for full mesh
+    uint32_t first;         // first cluster
+    uint32_t count;         // number of clusters
+    uint32_t reserved;
+    uint64_t vertex_count;  // sum over clusters, shared vertices counted once per cluster
+    uint64_t face_count;
+};
+
+// geometry of cluster, arrays point into mapped sidecar, drawn like a mesh without hierarchy
+class ClusterView {
+public:
+    const float *x = nullptr, *y = nullptr, *z = nullptr;   // vertex coordinates
+    const unsigned int *indices = nullptr;                  // cluster local vertex indices, 3 per face
+    const uint16_t *materials = nullptr;                    // material index per face or NO_MATERIAL
+    const float *nx = nullptr, *ny = nullptr, *nz = nullptr;    // unit face normal in object space
+    std::span<const char> luminance;                        // always empty, light is never baked into sidecar
+    std::span<const BvhNode> nodes;                         // always empty, faces are drawn in stored order
+    size_t vertices = 0, faces = 0;
+
+    [[nodiscard]] size_t vertex_count() const { return vertices; }
+    [[nodiscard]] size_t face_count() const { return faces; }
+    [[nodiscard]] Vec3 normal(const size_t f) const { return {nx[f], ny[f], nz[f]}; }
+};
+
+// clustered sidecar (.objs) of prepared object, every level of detail cut into hierarchy subtrees
+// that are paged in on first use and dropped least recently used first once resident data exceeds budget
+class ClusterFile {
+public:
+    // transforms baked into sidecar, it is valid only for same ones
+    static constexpr uint32_t COLOR = 1u << 0;
+    static constexpr uint32_t FLIP = 1u << 1;
+    static constexpr uint32_t INVERT_X = 1u << 2;
+    static constexpr uint32_t INVERT_Y = 1u << 3;
+    static constexpr uint32_t INVERT_Z = 1u << 4;
+    static constexpr uint32_t LOD = 1u << 5;
+
+    std::vector<ClusterLevel> levels;           // finest first
+    std::vector<ClusterRecord> clusters;        // of all levels, each level in depth first order of its hierarchy
+    std::vector<float> hull_x, hull_y, hull_z;  // points centering the model on screen, few enough to transform every frame
+    size_t max_vertices = 0;                    // vertices of biggest cluster
+
+    // sidecar path for obj file - same name with .objs extension
+    static std::filesystem::path path_for(const std::string &obj_filename);
+
+    // streamed object from sidecar, budget in bytes of resident cluster data,
+    // fails if sidecar is missing, obj file has changed since or it was written with other flags
+    static bool load(Object &obj, const std::string &obj_filename, uint32_t flags, size_t budget);
+
+    // write sidecar of complete prepared object, needs whole object in memory once
+    static bool save(const Object &obj, const std::string &obj_filename, uint32_t flags);
+
+    // starts reading clusters not resident yet in background, in given order until budget is filled
+    void prefetch(std::span<const unsigned int> order) const;
+
+    // pages cluster in, dropping least recently used ones over budget, false if its data is invalid
+    // dropped pages are read again on next touch, so renderers sharing file never see stale data
+    bool acquire(unsigned int cluster, ClusterView &view) const;
+
+    [[nodiscard]] size_t resident() const;      // bytes of clusters counted as resident
+
+private:
+    MappedFile file;
+    size_t budget = 0;
+    bool paged = true;      // clusters own whole pages, page advice touches no other cluster
+
+    // residency of clusters, recency list links clusters by index from newest to oldest
+    static constexpr unsigned int NONE = ~0u;
+    static constexpr uint8_t RESIDENT = 1u << 0;
+    static constexpr uint8_t CHECKED = 1u << 1;     // indices and materials were validated
+    static constexpr uint8_t INVALID = 1u << 2;
+
+    mutable std::mutex mutex;
+    mutable std::vector<uint8_t> state;
+    mutable std::vector<unsigned int> newer, older;
+    mutable unsigned int newest = NONE, oldest = NONE;
+    mutable size_t resident_bytes = 0;
+    uint32_t material_count = 0;
+
+    [[nodiscard]] size_t span(unsigned int cluster) const;  // bytes of cluster rounded up to block alignment
+    void unlink(unsigned int cluster) const;
+    void link_newest(unsigned int cluster) const;
+    [[nodiscard]] bool validate(const ClusterRecord &record) const;
+};
@@ -0,0 +1,307 @@
+/*
+ * ansi.cpp
+ */
+
+#include "ansi.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+// helper functions
+
+static void append_number(std::string &out, const unsigned int value)
+{
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+static unsigned int channel(const float value)
+{
+    return static_cast<unsigned int>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+std::string truecolor(const Vec3 &rgb, const bool background)
+{
+    std::string sgr = background ? "\x1b[48;2;" : "\x1b[38;2;";
+    append_number(sgr, channel(rgb.x));
+    sgr += ';';
+    append_number(sgr, channel(rgb.y));
+    sgr += ';';
+    append_number(sgr, channel(rgb.z));
+    sgr += 'm';
+    return sgr;
+}
+
+// AnsiEncoder methods
+
+AnsiEncoder::AnsiEncoder(const std::vector<Material> &materials, const std::string_view base, const std::string_view plain) : base(base), plain(plain)
+{
+    set_materials(materials);
+}
+
+void AnsiEncoder::set_materials(const std::vector<Material> &materials)
+{
+    palette.clear();
+    palette.reserve(materials.size());
+    for (const auto &material : materials)
+    {
+        palette.push_back(truecolor(material.diffuse));
+    }
+
+    invalidate();
+}
+
+void AnsiEncoder::invalidate()
+{
+    std::fill(stale.begin(), stale.end(), true);
+    cursor_row = cursor_col = UNKNOWN;
+    color = UNKNOWN;
+}
+
+void AnsiEncoder::move(const unsigned int row, const unsigned int col, std::string &out)
+{
+    if (cursor_row == static_cast<int>(row) && cursor_col == static_cast<int>(col))
+        return;
+
+    // forward on same row is shorter, cup is 1-based
+    if (cursor_row == static_cast<int>(row) && cursor_col != UNKNOWN && static_cast<int>(col) > cursor_col)
+    {
+        out += "\x1b[";
+        append_number(out, col - static_cast<unsigned int>(cursor_col));
+        out += 'C';
+        cursor_col = static_cast<int>(col);
+        return;
+    }
+
+    out += "\x1b[";
+    append_number(out, row + 1);
+    out += ';';
+    append_number(out, col + 1);
+    out += 'H';
+
+    cursor_row = static_cast<int>(row);
+    cursor_col = static_cast<int>(col);
+}
+
+void AnsiEncoder::set_color(const uint16_t material, std::string &out)
+{
+    if (color == material)
+        return;
+
+    out += material < palette.size() ? palette[material] : plain;
+    color = material;
+}
+
+void AnsiEncoder::write_text(const char *text, const unsigned int count, std::string &out)
+{
+    out.append(text, count);
+    cursor_col += static_cast<int>(count);
+
+    // cursor in last column waits for wrap, position is not reliable
+    if (cursor_col >= static_cast<int>(x))
+        cursor_row = cursor_col = UNKNOWN;
+}
+
+void AnsiEncoder::encode(const Buffer &buf, std::string &out)
+{
+    // new size, nothing on terminal is known
+    if (buf.x != x || buf.y != y)
+    {
+        x = buf.x;
+        y = buf.y;
+        glyphs.assign(static_cast<size_t>(x) * y, ' ');
+        materials.assign(static_cast<size_t>(x) * y, NO_MATERIAL);
+        stale.assign(y, true);
+        cursor_row = cursor_col = UNKNOWN;
+        color = UNKNOWN;
+    }
+
+    cells = 0;
+
+    // base sgr resets foreground too
+    out += base;
+    color = UNKNOWN;
+
+    if (palette.empty())
+        encode_rows<false>(buf, out);
+    else
+        encode_rows<true>(buf, out);
+}
+
+template<bool colored>
+void AnsiEncoder::encode_rows(const Buffer &buf, std::string &out)
+{
+    for (unsigned int row = 0; row < y; row++)
+    {
+        const size_t offset = static_cast<size_t>(row) * x;
+        const char *next_glyphs = buf.glyphs.data() + offset;
+        const uint16_t *next_materials = buf.materials.data() + offset;
+        char *prev_glyphs = glyphs.data() + offset;
+        uint16_t *prev_materials = materials.data() + offset;
+
+        const bool whole = stale[row];
+        stale[row] = false;
+
+        if (!whole && std::memcmp(next_glyphs, prev_glyphs, x) == 0 && (!colored || std::memcmp(next_materials, prev_materials, x * sizeof(uint16_t)) == 0))
+            continue;
+
+        auto changed = [&](const unsigned int c) {
+            if constexpr (colored)
+                return whole || next_glyphs[c] != prev_glyphs[c] || next_materials[c] != prev_materials[c];
+            else
+                return whole || next_glyphs[c] != prev_glyphs[c];
+        };
+
+        // blank tail of rewritten row is erased instead of written
+        unsigned int tail = x;
+        if (whole)
+        {
+            while (tail > 0 && next_glyphs[tail - 1] == ' ')
+                tail--;
+        }
+
+        unsigned int col = 0;
+        while (col < tail)
+        {
+            if (!changed(col))
+            {
+                col++;
+                continue;
+            }
+
+            // changed run, short unchanged gaps are rewritten because cursor move costs more
+            const unsigned int start = col;
+            unsigned int end = col;
+            while (col < tail)
+            {
+                if (changed(col))
+                {
+                    end = ++col;
+                    continue;
+                }
+
+                unsigned int gap = col;
+                while (gap < tail && gap - col < ANSI_GAP_CELLS && !changed(gap))
+                    gap++;
+
+                if (gap == tail || !changed(gap))
+                    break;
+
+                col = gap;
+            }
+            col = end;
+
+            move(row, start, out);
+            for (unsigned int run = start; run < end;)
+            {
+                // without color whole run has one foreground
+                const uint16_t material = colored ? next_materials[run] : NO_MATERIAL;
+                const unsigned int stop = colored ? static_cast<unsigned int>(std::find_if(next_materials + run, next_materials + end, [&](const uint16_t m) { return m != material; }) - next_materials) : end;
+
+                // blank cells look the same in every foreground
+                if (!std::all_of(next_glyphs + run, next_glyphs + stop, [](const char c) { return c == ' '; }))
+                    set_color(material, out);
+
+                write_text(next_glyphs + run, stop - run, out);
+                run = stop;
+            }
+
+            cells += end - start;
+        }
+
+        if (tail < x)
+        {
+            move(row, tail, out);
+            out += "\x1b[K";
+            cells += x - tail;
+        }
+
+        std::memcpy(prev_glyphs, next_glyphs, x);
+        if constexpr (colored)
+            std::memcpy(prev_materials, next_materials, x * sizeof(uint16_t));
+    }
+}
+
+// text looks as cells without material, previous frame takes it over and next encode diffs against it
+void AnsiEncoder::overlay(const unsigned int row, const std::string_view text, std::string &out)
+{
+    if (row >= y)
+        return;
+
+    const auto count = static_cast<unsigned int>(std::min<size_t>(text.size(), x));
+    char *prev_glyphs = glyphs.data() + static_cast<size_t>(row) * x;
+    uint16_t *prev_materials = materials.data() + static_cast<size_t>(row) * x;
+
+    for (unsigned int col = 0; col < count;)
+    {
+        if (prev_glyphs[col] == text[col] && prev_materials[col] == NO_MATERIAL)
+        {
+            col++;
+            continue;
+        }
+
+        const unsigned int start = col;
+        while (col < count && (prev_glyphs[col] != text[col] || prev_materials[col] != NO_MATERIAL))
+        {
+            prev_glyphs[col] = text[col];
+            prev_materials[col] = NO_MATERIAL;
+            col++;
+        }
+
+        move(row, start, out);
+        set_color(NO_MATERIAL, out);
+        write_text(text.data() + start, col - start, out);
+    }
+}
+
+// AnsiScreen methods
+
+AnsiScreen::AnsiScreen(const std::vector<Material> &materials, const std::string_view base, const std::string_view plain, const int fd)
+    : encoder(materials, base, plain), fd(fd) {}
+
+void AnsiScreen::present(const Buffer &buf)
+{
+    frame.clear();
+    frame.reserve(static_cast<size_t>(buf.x) * buf.y * 4);
+
+    encoder.encode(buf, frame);
+    cells = encoder.cells;
+}
+
+void AnsiScreen::overlay(const unsigned int row, const std::string_view text)
+{
+    encoder.overlay(row, text, frame);
+}
+
+void AnsiScreen::flush()
+{
+    // one write unless terminal takes partial frame
+    size_t done = 0;
+    while (done < frame.size())
+    {
+        const ssize_t n = ::write(fd, frame.data() + done, frame.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+
+        done += static_cast<size_t>(n);
+    }
+
+    bytes = static_cast<unsigned long>(done);
+    frame.clear();
+}
+
+void AnsiScreen::invalidate()
+{
+    encoder.invalidate();
+}
+
+void AnsiScreen::set_materials(const std::vector<Material> &materials)
+{
+    encoder.set_materials(materials);
+}
@@ -0,0 +1,82 @@
+/*
+ * ansi.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buffer.h"
+#include "presenter.h"
+#include "entities/geometry/object.h"
+#include "utils/mathematics.h"
+
+// truecolor sgr sequence of rgb color with components 0-1
+std::string truecolor(const Vec3 &rgb, bool background = false);
+
+// encodes frames into ansi escape sequences, only cells changed since previous frame
+// colors come straight from material diffuse, sgr is written only where color changes
+class AnsiEncoder {
+public:
+    unsigned long cells = 0;    // cells written by last encode
+
+    // base - sgr starting every frame (background), plain - foreground of cells without material or when palette is empty
+    explicit AnsiEncoder(const std::vector<Material> &materials = {}, std::string_view base = "\x1b[0m", std::string_view plain = "\x1b[39m");
+
+    // appends sequences that turn previous frame into buffer
+    void encode(const Buffer &buf, std::string &out);
+
+    // appends text at start of row in plain foreground, only cells that differ on terminal
+    void overlay(unsigned int row, std::string_view text, std::string &out);
+
+    // forget previous frame, next encode writes every cell
+    void invalidate();
+
+    // palette of new materials, whole next frame is written with it
+    void set_materials(const std::vector<Material> &materials);
+
+private:
+    static constexpr int UNKNOWN = -1;
+
+    std::string base;
+    std::vector<std::string> palette;   // foreground sgr per material
+    std::string plain;                  // foreground sgr of cells without material
+
+    unsigned int x = 0, y = 0;
+    std::vector<char> glyphs;           // previous frame
+    std::vector<uint16_t> materials;
+    std::vector<bool> stale;            // rows that must be rewritten
+
+    // terminal state after written bytes
+    int cursor_row = UNKNOWN, cursor_col = UNKNOWN;
+    int color = UNKNOWN;                // material of current sgr
+
+    void move(unsigned int row, unsigned int col, std::string &out);
+    void set_color(uint16_t material, std::string &out);
+    void write_text(const char *text, unsigned int count, std::string &out);
+
+    // diff of rows, without color (empty palette) every cell looks plain and material plane is ignored
+    template<bool color>
+    void encode_rows(const Buffer &buf, std::string &out);
+};
+
+// raw terminal presenter, whole frame goes out in one write
+class AnsiScreen : public Presenter {
+public:
+    // base and plain as in AnsiEncoder, fd - terminal
+    AnsiScreen(const std::vector<Material> &materials, std::string_view base, std::string_view plain, int fd);
+
+    void present(const Buffer &buf) override;
+    void overlay(unsigned int row, std::string_view text) override;
+    void flush() override;
+    void invalidate() override;
+    void set_materials(const std::vector<Material> &materials) override;
+
+private:
+    AnsiEncoder encoder;
+    std::string frame;                  // bytes of frame, capacity kept between frames
+    int fd;
+};
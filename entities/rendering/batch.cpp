@@ -0,0 +1,158 @@
+/*
+ * batch.cpp
+ */
+
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+
+#include "utils/parallel.h"
+#include "utils/thread_pool.h"
+
+using SteadyClock = std::chrono::steady_clock;
+
+// helpers
+
+static bool is_obj(const std::filesystem::path &path)
+{
+    std::string extension = path.extension().string();
+    std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".obj";
+}
+
+static const char *extension_of(const ExportFormat format)
+{
+    return format == ExportFormat::Asciicast ? ".cast" : ".ans";
+}
+
+// Batch methods
+
+std::vector<std::string> Batch::collect(const std::vector<std::filesystem::path> &paths)
+{
+    std::vector<std::string> inputs;
+
+    for (const auto &path : paths)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(path, error))
+        {
+            inputs.push_back(path.string());
+            continue;
+        }
+
+        std::vector<std::string> found;
+        for (const auto &entry : std::filesystem::directory_iterator(path, error))
+        {
+            if (entry.is_regular_file(error) && is_obj(entry.path()))
+                found.push_back(entry.path().string());
+        }
+
+        if (error)
+        {
+            std::cerr << "warning: can't list directory " << path.string() << '\n';
+        }
+
+        std::ranges::sort(found);
+        inputs.insert(inputs.end(), found.begin(), found.end());
+    }
+
+    return inputs;
+}
+
+std::vector<BatchItem> Batch::plan(const std::vector<std::string> &inputs, const std::filesystem::path &directory, const ExportFormat format)
+{
+    std::vector<BatchItem> items;
+    items.reserve(inputs.size());
+
+    // workers write outputs at once, so every item needs its own file
+    std::set<std::filesystem::path> taken;
+
+    for (const auto &input : inputs)
+    {
+        std::filesystem::path output = input;
+        output.replace_extension(extension_of(format));
+
+        if (!directory.empty())
+            output = directory / output.filename();
+
+        // same names from different directories get numbered, model.ans, model-2.ans, ...
+        const std::filesystem::path stem = output.parent_path() / output.stem();
+        for (unsigned int n = 2; taken.contains(output.lexically_normal()); n++)
+            output = stem.string() + "-" + std::to_string(n) + extension_of(format);
+
+        taken.insert(output.lexically_normal());
+        items.push_back({input, output});
+    }
+
+    return items;
+}
+
+bool Batch::run(const std::vector<BatchItem> &items, const BatchLoader &load, const Camera &start, const Light &light,
+                const ExportOptions &options, const unsigned jobs, std::ostream &out)
+{
+    std::mutex report;
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> triangles{0};
+
+    const auto begin = SteadyClock::now();
+
+    // one model per worker, while some wait on file reads others render
+    parallel_for(items.size(), jobs, [&](const size_t i) {
+        const BatchItem &item = items[i];
+        bool ok = false;
+        size_t faces = 0;
+
+        {
+            Object obj;
+            if (load(item.input, obj))
+            {
+                std::ofstream file(item.output, std::ios::binary);
+
+                if (!file)
+                {
+                    std::lock_guard lock(report);
+                    std::cerr << "error: can't open output file " << item.output.string() << '\n';
+                }
+                else
+                {
+                    // models are the parallel unit, frames of one model are drawn by its worker alone
+                    ThreadPool single(1);
+                    ok = Exporter::run(obj, start, light, options, single, file);
+                    faces = obj.face_count();
+                }
+            }
+        }   // model memory released before next one is taken
+
+        std::lock_guard lock(report);
+        if (ok)
+        {
+            triangles += faces * options.frames;
+            out << item.input << " -> " << item.output.string() << '\n';
+        }
+        else
+        {
+            failed++;
+            std::cerr << "error: failed to export " << item.input << '\n';
+        }
+    });
+
+    const double seconds = std::chrono::duration<double>(SteadyClock::now() - begin).count();
+    const size_t done = items.size() - failed;
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%zu models, %zu failed, %.3f s, %.2f models/s, %.3g triangles/s\n",
+                  done, failed.load(), seconds,
+                  seconds > 0.0 ? static_cast<double>(done) / seconds : 0.0,
+                  seconds > 0.0 ? static_cast<double>(triangles) / seconds : 0.0);
+    out << line << std::flush;
+
+    return failed == 0;
+}
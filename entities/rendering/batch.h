@@ -0,0 +1,40 @@
+/*
+ * batch.h
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "export.h"
+#include "entities/geometry/object.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+
+// model of batch and file its frames are written to
+class BatchItem {
+public:
+    std::string input;
+    std::filesystem::path output;
+};
+
+// loads and prepares model for rendering, false if it can't be used
+using BatchLoader = std::function<bool(const std::string &input, Object &obj)>;
+
+class Batch {
+public:
+    // input paths with directories expanded to obj files they contain, sorted by name
+    static std::vector<std::string> collect(const std::vector<std::filesystem::path> &paths);
+
+    // output file of every input, next to input or in given directory, clashing names are numbered
+    static std::vector<BatchItem> plan(const std::vector<std::string> &inputs, const std::filesystem::path &directory, ExportFormat format);
+
+    // exports every model, up to jobs models are loaded and rendered at once and released after their file is written
+    // prints throughput summary, false if any model failed
+    static bool run(const std::vector<BatchItem> &items, const BatchLoader &load, const Camera &start, const Light &light,
+                    const ExportOptions &options, unsigned jobs, std::ostream &out);
+};
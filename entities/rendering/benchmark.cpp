@@ -0,0 +1,152 @@
+/*
+ * benchmark.cpp
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <numbers>
+
+#include "utils/tools.h"
+
+using SteadyClock = std::chrono::steady_clock;
+
+// helpers
+
+static double elapsed_ms(const SteadyClock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(SteadyClock::now() - start).count();
+}
+
+static std::string json_escape(const std::string &text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    append_json(escaped, text);
+    return escaped;
+}
+
+// StageSummary methods
+
+StageSummary StageSummary::of(std::vector<double> samples)
+{
+    StageSummary summary;
+    if (samples.empty())
+        return summary;
+
+    std::ranges::sort(samples);
+
+    // nearest rank percentiles
+    const auto rank = [&](const double p) {
+        const auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(samples.size())));
+        return samples[std::clamp(index, static_cast<size_t>(1), samples.size()) - 1];
+    };
+
+    summary.min = samples.front();
+    summary.median = rank(0.5);
+    summary.p99 = rank(0.99);
+    return summary;
+}
+
+// Benchmark methods
+
+void Benchmark::serialize(const Buffer &buf, std::string &text)
+{
+    text.resize(static_cast<size_t>(buf.x + 1) * buf.y);
+
+    char *dst = text.data();
+    for (unsigned int row = 0; row < buf.y; row++)
+    {
+        std::copy_n(buf.glyphs.data() + static_cast<size_t>(row) * buf.x, buf.x, dst);
+        dst += buf.x;
+        *dst++ = '\n';
+    }
+}
+
+void Benchmark::run(const std::string &name, const Object &obj, const Camera &start, const Light &light,
+                    const BenchmarkOptions &options, ThreadPool &pool, std::ostream &out)
+{
+    const float logical_y = 2.0f;
+    const float logical_x = logical_y * static_cast<float>(options.width) / (static_cast<float>(options.height) * CHAR_ASPECT_RATIO);
+
+    Buffer buf(options.width, options.height, logical_x, logical_y);
+    Camera cam = start;
+
+    Renderer renderer(options.front_to_back);
+    renderer.reserve(obj);
+    std::string text;
+
+    const size_t frames = options.frames;
+    std::vector<double> clear(frames), transform(frames), cull(frames), raster(frames), serialization(frames), total(frames);
+
+    // one full turn of azimuth with altitude swinging around start
+    for (size_t k = 0; k < frames; k++)
+    {
+        const float phase = 2.0f * std::numbers::pi_v<float> * static_cast<float>(k) / static_cast<float>(frames);
+        cam.azimuth = start.azimuth + phase;
+        cam.altitude = start.altitude + BENCH_ORBIT_ALTITUDE * std::sin(phase);
+
+        const auto frame_start = SteadyClock::now();
+
+        buf.clear();
+        clear[k] = elapsed_ms(frame_start);
+
+        RenderStats stats;
+        renderer.render(buf, obj, cam, light, options.static_light, options.color_support, &pool, &stats);
+        transform[k] = stats.transform;
+        cull[k] = stats.cull;
+        raster[k] = stats.raster;
+
+        const auto serialize_start = SteadyClock::now();
+        serialize(buf, text);
+        serialization[k] = elapsed_ms(serialize_start);
+
+        total[k] = elapsed_ms(frame_start);
+    }
+
+    const std::pair<const char *, StageSummary> stages[] = {
+        {"clear", StageSummary::of(clear)},
+        {"transform", StageSummary::of(transform)},
+        {"cull", StageSummary::of(cull)},
+        {"raster", StageSummary::of(raster)},
+        {"serialize", StageSummary::of(serialization)},
+        {"frame", StageSummary::of(total)},
+    };
+
+    if (options.json)
+    {
+        out << std::setprecision(6)
+            << "{\"model\": \"" << json_escape(name) << "\""
+            << ", \"frames\": " << frames
+            << ", \"width\": " << options.width
+            << ", \"height\": " << options.height
+            << ", \"threads\": " << pool.size()
+            << ", \"vertices\": " << obj.vertex_count()
+            << ", \"faces\": " << obj.face_count()
+            << ", \"stages_ms\": {";
+
+        for (size_t i = 0; i < std::size(stages); i++)
+        {
+            const auto &[stage, summary] = stages[i];
+            out << (i ? ", " : "") << "\"" << stage << "\": {\"min\": " << summary.min << ", \"median\": " << summary.median << ", \"p99\": " << summary.p99 << "}";
+        }
+
+        out << "}}\n";
+        return;
+    }
+
+    out << name << ": " << options.width << "x" << options.height << ", " << frames << " frames, " << pool.size() << " threads, "
+        << obj.vertex_count() << " vertices, " << obj.face_count() << " faces\n"
+        << std::left << std::setw(12) << "stage" << std::right << std::setw(10) << "min" << std::setw(10) << "median" << std::setw(10) << "p99" << "  (ms)\n"
+        << std::fixed << std::setprecision(3);
+
+    for (const auto &[stage, summary] : stages)
+    {
+        out << std::left << std::setw(12) << stage << std::right << std::setw(10) << summary.min << std::setw(10) << summary.median << std::setw(10) << summary.p99 << '\n';
+    }
+
+    out << std::defaultfloat;
+}
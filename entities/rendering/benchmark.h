@@ -0,0 +1,49 @@
+/*
+ * benchmark.h
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "renderer.h"
+#include "entities/geometry/object.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+#include "utils/thread_pool.h"
+#include "config.h"
+
+// parameters of headless run
+class BenchmarkOptions {
+public:
+    unsigned int frames = 0;
+    unsigned int width = BENCH_WIDTH;       // buffer size in characters
+    unsigned int height = BENCH_HEIGHT;
+    bool json = false;                      // machine readable report
+    bool static_light = false;
+    bool color_support = false;
+    bool front_to_back = true;              // see Renderer
+};
+
+// distribution of one stage over all frames, milliseconds
+class StageSummary {
+public:
+    double min = 0.0;
+    double median = 0.0;
+    double p99 = 0.0;
+
+    static StageSummary of(std::vector<double> samples);
+};
+
+class Benchmark {
+public:
+    // renders frames along fixed orbit starting at camera into off-screen buffer, writes report
+    static void run(const std::string &name, const Object &obj, const Camera &start, const Light &light,
+                    const BenchmarkOptions &options, ThreadPool &pool, std::ostream &out);
+
+    // plain text frame, one line per row, stands in for terminal output
+    static void serialize(const Buffer &buf, std::string &text);
+};
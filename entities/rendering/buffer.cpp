@@ -4,69 +4,40 @@
 
 #include "buffer.h"
 
-#include <array>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
-// Projection methods
+static_assert(RASTER_TILE_X % HIZ_BLOCK_X == 0 && RASTER_TILE_Y % HIZ_BLOCK_Y == 0, "depth blocks must not cross tiles");
 
-Projection Projection::sort_x() const
-{
-    std::array arr = {p1, p2, p3};
-
-    std::ranges::sort(arr, [](const Vec3 &a, const Vec3 &b) { return a.x < b.x; });
+// helpers
 
-    return {arr[0], arr[1], arr[2], color};
-}
-
-float Projection::limit_y1(const float x) const
+// pixel index range [first, last) of centers inside [low, high], clamped to [0, size)
+static void pixel_range(const float low, const float high, const int size, int &first, int &last)
 {
-    if (x <= p1.x) return p1.y;
-    if (x >= p3.x) return p3.y;
-
-    if (x <= p2.x)
-    {
-        const float denominator = p2.x - p1.x;
-
-        if (std::fabs(denominator) < 1e-7f)
-            return p1.y;
-
-        const float t = (x - p1.x) / denominator;
-        return lerp(p1.y, p2.y, t);
-    }
-    else
-    {
-        const float denominator = p3.x - p2.x;
-
-        if (std::fabs(denominator) < 1e-7f)
-            return p2.y;
-
-        const float t = (x - p2.x) / denominator;
-        return lerp(p2.y, p3.y, t);
-    }
-}
-
-float Projection::limit_y2(const float x) const
-{
-    if (x <= p1.x)
-        return p1.y;
-    if (x >= p3.x)
-        return p3.y;
-
-    const float denominator = p3.x - p1.x;
-
-    if (std::fabs(denominator) < 1e-7f)
-        return p1.y;
-
-    const float t = (x - p1.x) / denominator;
-    return lerp(p1.y, p3.y, t);
+    // clamping before conversion keeps casts defined, rounding by hand avoids floor/ceil calls without sse4.1
+    const float l = std::clamp(low, 0.0f, static_cast<float>(size));
+    const float h = std::clamp(high, -1.0f, static_cast<float>(size - 1));
+
+    first = static_cast<int>(l);
+    if (static_cast<float>(first) < l)
+        first++;
+
+    last = static_cast<int>(h);
+    if (static_cast<float>(last) > h)
+        last--;
+    last++;
 }
 
-Vec3 Projection::normal() const
+// set lanes of movemask, table instead of popcount call on builds without popcnt instruction
+static size_t lanes(const int mask)
 {
-    const Vec3 v1 = p2 - p1;
-    const Vec3 v2 = p3 - p1;
-    const Vec3 n = Vec3::cross(v1, v2);
-
-    return n.normalize();
+    static constexpr unsigned char NIBBLE_BITS[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    return NIBBLE_BITS[mask & 15] + NIBBLE_BITS[(mask >> 4) & 15];
 }
 
 // Buffer methods
@@ -81,132 +52,444 @@ Buffer::Buffer(const unsigned int x, const unsigned int y, const float logical_x
     dx = logical_x / static_cast<float>(x);
     dy = logical_y / static_cast<float>(y);
 
-    pixels.resize(x * y);
+    depth.resize(x * y);
+    glyphs.resize(x * y);
+    materials.resize(x * y);
+
+    blocks_x = (x + HIZ_BLOCK_X - 1) / HIZ_BLOCK_X;
+    blocks_y = (y + HIZ_BLOCK_Y - 1) / HIZ_BLOCK_Y;
+    block_depth.resize(static_cast<size_t>(blocks_x) * blocks_y);
+    block_dirty.resize(block_depth.size());
 
     clear();
 }
 
 void Buffer::clear()
 {
-    for (auto &p : pixels)
-    {
-        p.z = std::numeric_limits<float>::max();
-        p.c = ' ';
-        p.material = std::nullopt;
-    }
+    std::ranges::fill(depth, std::numeric_limits<float>::max());
+    std::ranges::fill(glyphs, ' ');
+    std::ranges::fill(materials, NO_MATERIAL);
+    std::ranges::fill(block_depth, std::numeric_limits<float>::max());
+    std::ranges::fill(block_dirty, 0);
 }
 
-int Buffer::index_x(const float real_x) const
+void Buffer::draw_projection(const Projection &projection, const char c, const uint16_t material, RasterStats *stats)
 {
-    int index = static_cast<int>(real_x / dx);
-    index = clamp(index, 0, static_cast<int>(x) - 1);
+    Triangle triangle{};
+    if (setup(projection, c, material, triangle))
+    {
+        RasterStats counts;
+        counts.triangles = 1;
+        rasterize(triangle, {0, static_cast<int>(x), 0, static_cast<int>(y)}, counts);
 
-    return index;
+        if (stats)
+            *stats += counts;
+    }
 }
 
-int Buffer::index_y(const float real_y) const
+void Buffer::draw_projections(const std::vector<Projection> &projections, ThreadPool *pool, RasterStats *stats)
 {
-    int iy = static_cast<int>(real_y / dy);
-    iy = clamp(iy, 0, static_cast<int>(y) - 1);
+    if (!pool || pool->size() <= 1)
+    {
+        for (const auto &projection : projections)
+        {
+            draw_projection(projection, projection.color, projection.material, stats);
+        }
+        return;
+    }
+
+    const int tiles_x = static_cast<int>((x + RASTER_TILE_X - 1) / RASTER_TILE_X);
+    const int tiles_y = static_cast<int>((y + RASTER_TILE_Y - 1) / RASTER_TILE_Y);
+
+    // setup once, binning in submission order so every tile keeps z-test order of single threaded drawing
+    triangles.clear();
+    triangles.reserve(projections.size());
+
+    bins.resize(static_cast<size_t>(tiles_x * tiles_y));
+    for (auto &bin : bins)
+        bin.clear();
+
+    tile_stats.assign(bins.size(), RasterStats{});
 
-    return iy;
+    for (const auto &projection : projections)
+    {
+        Triangle triangle{};
+        if (!setup(projection, projection.color, projection.material, triangle))
+            continue;
+
+        const int tx0 = triangle.x0 / static_cast<int>(RASTER_TILE_X);
+        const int tx1 = (triangle.x1 - 1) / static_cast<int>(RASTER_TILE_X);
+        const int ty0 = triangle.y0 / static_cast<int>(RASTER_TILE_Y);
+        const int ty1 = (triangle.y1 - 1) / static_cast<int>(RASTER_TILE_Y);
+
+        const auto index = static_cast<unsigned int>(triangles.size());
+        triangles.push_back(triangle);
+
+        for (int ty = ty0; ty <= ty1; ty++)
+        {
+            for (int tx = tx0; tx <= tx1; tx++)
+            {
+                bins[ty * tiles_x + tx].push_back(index);
+            }
+        }
+    }
+
+    // tiles own disjoint pixels, no synchronization needed
+    pool->parallel_for(bins.size(), [&](const size_t t) {
+        const int tx = static_cast<int>(t) % tiles_x;
+        const int ty = static_cast<int>(t) / tiles_x;
+
+        const Tile tile{
+            tx * static_cast<int>(RASTER_TILE_X),
+            std::min((tx + 1) * static_cast<int>(RASTER_TILE_X), static_cast<int>(x)),
+            ty * static_cast<int>(RASTER_TILE_Y),
+            std::min((ty + 1) * static_cast<int>(RASTER_TILE_Y), static_cast<int>(y))
+        };
+
+        for (const unsigned int i : bins[t])
+        {
+            rasterize(triangles[i], tile, tile_stats[t]);
+        }
+    });
+
+    if (stats)
+    {
+        stats->triangles += triangles.size();
+        for (const auto &counts : tile_stats)
+        {
+            stats->tested += counts.tested;
+            stats->written += counts.written;
+            stats->rejected += counts.rejected;
+        }
+    }
 }
 
-float Buffer::depth(const Projection &projection, const Vec3 &normal, const int pixel_x, const int pixel_y) const
+bool Buffer::setup(const Projection &projection, const char c, const uint16_t material, Triangle &triangle) const
 {
-    const float center_x = (static_cast<float>(pixel_x) + 0.5f) * dx;
-    const float center_y = (static_cast<float>(pixel_y) + 0.5f) * dy;
+    // pixel space, center of pixel (i, j) at (i, j)
+    const float inv_dx = 1.0f / dx;
+    const float inv_dy = 1.0f / dy;
+
+    const float vx[3] = {projection.p1.x * inv_dx - 0.5f, projection.p2.x * inv_dx - 0.5f, projection.p3.x * inv_dx - 0.5f};
+    const float vy[3] = {projection.p1.y * inv_dy - 0.5f, projection.p2.y * inv_dy - 0.5f, projection.p3.y * inv_dy - 0.5f};
+    const float vz[3] = {projection.p1.z, projection.p2.z, projection.p3.z};
+
+    const float e1x = vx[1] - vx[0], e1y = vy[1] - vy[0], e1z = vz[1] - vz[0];
+    const float e2x = vx[2] - vx[0], e2y = vy[2] - vy[0], e2z = vz[2] - vz[0];
+
+    const float area = e1x * e2y - e1y * e2x;
+    if (!(std::fabs(area) > 1e-12f))
+        return false;
+
+    pixel_range(std::min({vx[0], vx[1], vx[2]}), std::max({vx[0], vx[1], vx[2]}), static_cast<int>(x), triangle.x0, triangle.x1);
+    pixel_range(std::min({vy[0], vy[1], vy[2]}), std::max({vy[0], vy[1], vy[2]}), static_cast<int>(y), triangle.y0, triangle.y1);
+
+    if (triangle.x0 >= triangle.x1 || triangle.y0 >= triangle.y1)
+        return false;
 
-    if (std::fabs(normal.z) < 1e-7f)
+    // edge i goes from vertex i to vertex i + 1 and is positive inside
+    // shared edges are always built in the same vertex order and only negated, so neighbours agree exactly
+    for (int i = 0; i < 3; i++)
     {
-        return projection.p1.z;
+        int from = i;
+        int to = (i + 1) % 3;
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+
+        if (vx[to] < vx[from] || (vx[to] == vx[from] && vy[to] < vy[from]))
+        {
+            std::swap(from, to);
+            sign = -sign;
+        }
+
+        const float ex = vx[to] - vx[from];
+        const float ey = vy[to] - vy[from];
+
+        triangle.a[i] = -ey * sign;
+        triangle.b[i] = ex * sign;
+        triangle.c[i] = (ey * vx[from] - ex * vy[from]) * sign;
     }
 
-    const float d_z = normal.x * (center_x - projection.p1.x) + normal.y * (center_y - projection.p1.y);
-    const float z  = projection.p1.z - d_z / normal.z;
+    // depth plane solved once instead of per pixel
+    triangle.dzdx = (e1z * e2y - e2z * e1y) / area;
+    triangle.dzdy = (e2z * e1x - e1z * e2x) / area;
+    triangle.z0 = vz[0] - triangle.dzdx * vx[0] - triangle.dzdy * vy[0];
+    triangle.z_min = std::min({vz[0], vz[1], vz[2]});
 
-    return z;
+    triangle.color = c;
+    triangle.material = material;
+    return true;
 }
 
-void Buffer::draw_projection(const Projection &projection, const char c, int material)
+void Buffer::rasterize(const Triangle &triangle, const Tile &tile, RasterStats &stats)
 {
-    const Projection triangle = projection.sort_x();
-
-    const float x_i = triangle.p1.x + dx * 0.5f;
-    const float x_f = triangle.p3.x - dx * 0.5f;
-    if (x_f < 0.f || x_i > logical_x)
-        return;
+    // counted locally, stored once per triangle
+    size_t tested = 0;
+    size_t written = 0;
+
+    const int x_start = std::max(triangle.x0, tile.x0);
+    const int x_end = std::min(triangle.x1, tile.x1);
+    const int y_start = std::max(triangle.y0, tile.y0);
+    const int y_end = std::min(triangle.y1, tile.y1);
+
+    // whole triangle behind drawn pixels of tile, small ones neither test nor refresh blocks
+    const bool coarse = (x_end - x_start) * (y_end - y_start) >= HIZ_MIN_PIXELS;
+    if (coarse)
+    {
+        // pixel depth comes from plane, not from vertices - margin covers its rounding and pixels passing edge tests just outside
+        const float slope = std::fabs(triangle.dzdx) + std::fabs(triangle.dzdy);
+        const float magnitude = std::fabs(triangle.z0) + std::fabs(triangle.dzdx) * static_cast<float>(x_end) + std::fabs(triangle.dzdy) * static_cast<float>(y_end);
 
-    const int x_start = index_x(x_i);
-    const int x_end   = index_x(x_f);
+        if (occluded(triangle.z_min - 1e-5f * magnitude - 1e-3f * slope, x_start, x_end, y_start, y_end))
+        {
+            stats.rejected++;
+            return;
+        }
+    }
 
-    const Vec3 normal = triangle.normal();
+    // reciprocal slopes for row spans
+    float inv_a[3];
+    for (int i = 0; i < 3; i++)
+    {
+        inv_a[i] = triangle.a[i] != 0.0f ? 1.0f / triangle.a[i] : 0.0f;
+    }
 
-    for (int pixel_x = x_start; pixel_x <= x_end; pixel_x++)
+    for (int pixel_y = y_start; pixel_y < y_end; pixel_y++)
     {
-        const float rx = (static_cast<float>(pixel_x) + 0.5f) * dx;
+        const auto fy = static_cast<float>(pixel_y);
 
-        float y1 = triangle.limit_y1(rx);
-        float y2 = triangle.limit_y2(rx);
+        // row constants, every pixel then costs one multiply and add per function
+        const float r0 = triangle.b[0] * fy + triangle.c[0];
+        const float r1 = triangle.b[1] * fy + triangle.c[1];
+        const float r2 = triangle.b[2] * fy + triangle.c[2];
+        const float rz = triangle.dzdy * fy + triangle.z0;
 
-        const float y_min = std::min(y1, y2);
-        const float y_max = std::max(y1, y2);
+        // conservative span of row from edge crossings, margin so that exact tests below alone decide coverage
+        float span_low = static_cast<float>(x_start);
+        float span_high = static_cast<float>(x_end);
+        bool empty = false;
 
-        if (y_max < 0.f || y_min > logical_y)
+        const float r[3] = {r0, r1, r2};
+        for (int i = 0; i < 3; i++)
+        {
+            if (triangle.a[i] > 0.0f)
+                span_low = std::max(span_low, -r[i] * inv_a[i] - 2.0f);
+            else if (triangle.a[i] < 0.0f)
+                span_high = std::min(span_high, -r[i] * inv_a[i] + 2.0f);
+            else if (r[i] < 0.0f)
+                empty = true;
+        }
+
+        if (empty || !(span_low < span_high))
             continue;
 
-        const float y_start_val = y_min + dy * 0.5f;
-        const float y_end_val = y_max - dy * 0.5f;
+        // both bounds non negative here, truncation rounds down
+        const int row_end = static_cast<int>(span_high);
+
+        const size_t row = static_cast<size_t>(pixel_y) * x;
+        float *depth_row = depth.data() + row;
+        char *glyph_row = glyphs.data() + row;
+        uint16_t *material_row = materials.data() + row;
 
-        const int y_start = index_y(y_start_val);
-        const int y_end = index_y(y_end_val);
+        int pixel_x = static_cast<int>(span_low);
 
-        for (int pixel_y = y_start; pixel_y <= y_end; pixel_y++)
+        // depth plane is tested and written in simd, glyph and material only for passed lanes
+#if defined(__AVX__)
         {
-            Pixel &pixel = pixels[pixel_y * x + pixel_x];
+            const __m256 a0 = _mm256_set1_ps(triangle.a[0]), a1 = _mm256_set1_ps(triangle.a[1]), a2 = _mm256_set1_ps(triangle.a[2]);
+            const __m256 v0 = _mm256_set1_ps(r0), v1 = _mm256_set1_ps(r1), v2 = _mm256_set1_ps(r2);
+            const __m256 dz = _mm256_set1_ps(triangle.dzdx), vz = _mm256_set1_ps(rz);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
 
-            if (const float z = depth(triangle, normal, pixel_x, pixel_y); z < pixel.z)
+            for (; pixel_x + 8 <= row_end; pixel_x += 8)
             {
-                pixel.z = z;
-                pixel.c = c;
-                pixel.material = material;
+                const __m256 fx = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(pixel_x)), lane);
+
+                const __m256 w0 = _mm256_add_ps(v0, _mm256_mul_ps(a0, fx));
+                const __m256 w1 = _mm256_add_ps(v1, _mm256_mul_ps(a1, fx));
+                const __m256 w2 = _mm256_add_ps(v2, _mm256_mul_ps(a2, fx));
+
+                const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ), _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)), _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+                const int covered = _mm256_movemask_ps(inside);
+                if (covered == 0)
+                    continue;
+
+                tested += lanes(covered);
+
+                const __m256 z = _mm256_add_ps(vz, _mm256_mul_ps(dz, fx));
+                const __m256 old = _mm256_loadu_ps(depth_row + pixel_x);
+                const __m256 pass = _mm256_and_ps(inside, _mm256_cmp_ps(z, old, _CMP_LT_OQ));
+
+                int mask = _mm256_movemask_ps(pass);
+                if (mask == 0)
+                    continue;
+
+                written += lanes(mask);
+                _mm256_storeu_ps(depth_row + pixel_x, _mm256_blendv_ps(old, z, pass));
+
+                for (; mask; mask &= mask - 1)
+                {
+                    const int k = pixel_x + __builtin_ctz(static_cast<unsigned>(mask));
+                    glyph_row[k] = triangle.color;
+                    material_row[k] = triangle.material;
+                }
             }
         }
-    }
-}
+#elif defined(__SSE2__)
+        {
+            const __m128 a0 = _mm_set1_ps(triangle.a[0]), a1 = _mm_set1_ps(triangle.a[1]), a2 = _mm_set1_ps(triangle.a[2]);
+            const __m128 v0 = _mm_set1_ps(r0), v1 = _mm_set1_ps(r1), v2 = _mm_set1_ps(r2);
+            const __m128 dz = _mm_set1_ps(triangle.dzdx), vz = _mm_set1_ps(rz);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
 
-void Buffer::printw() const
-{
-    for (unsigned int row = 0; row < y; row++)
-    {
-        ::move(static_cast<int>(row), 0);
-        int prev_color = -1;
+            for (; pixel_x + 4 <= row_end; pixel_x += 4)
+            {
+                const __m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<float>(pixel_x)), lane);
+
+                const __m128 w0 = _mm_add_ps(v0, _mm_mul_ps(a0, fx));
+                const __m128 w1 = _mm_add_ps(v1, _mm_mul_ps(a1, fx));
+                const __m128 w2 = _mm_add_ps(v2, _mm_mul_ps(a2, fx));
+
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+                const int covered = _mm_movemask_ps(inside);
+                if (covered == 0)
+                    continue;
 
-        for (unsigned int col = 0; col < x; col++)
+                tested += lanes(covered);
+
+                const __m128 z = _mm_add_ps(vz, _mm_mul_ps(dz, fx));
+                const __m128 old = _mm_loadu_ps(depth_row + pixel_x);
+                const __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, old));
+
+                int mask = _mm_movemask_ps(pass);
+                if (mask == 0)
+                    continue;
+
+                written += lanes(mask);
+                _mm_storeu_ps(depth_row + pixel_x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, old)));
+
+                for (; mask; mask &= mask - 1)
+                {
+                    const int k = pixel_x + __builtin_ctz(static_cast<unsigned>(mask));
+                    glyph_row[k] = triangle.color;
+                    material_row[k] = triangle.material;
+                }
+            }
+        }
+#elif defined(__ARM_NEON)
         {
-            const Pixel &pixel = pixels[row * x + col];
+            const float32x4_t a0 = vdupq_n_f32(triangle.a[0]), a1 = vdupq_n_f32(triangle.a[1]), a2 = vdupq_n_f32(triangle.a[2]);
+            const float32x4_t v0 = vdupq_n_f32(r0), v1 = vdupq_n_f32(r1), v2 = vdupq_n_f32(r2);
+            const float32x4_t dz = vdupq_n_f32(triangle.dzdx), vz = vdupq_n_f32(rz);
+            const float32x4_t zero = vdupq_n_f32(0.0f);
+            const float lanes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+            const float32x4_t lane = vld1q_f32(lanes);
 
-            if (const int color = pixel.material ? (pixel.material.value() + 1) : 0; color != prev_color)
+            uint32_t passed[4];
+
+            for (; pixel_x + 4 <= row_end; pixel_x += 4)
             {
-                if (prev_color > 0)
+                const float32x4_t fx = vaddq_f32(vdupq_n_f32(static_cast<float>(pixel_x)), lane);
+
+                // separate multiply and add, fused vmla would round differently from scalar tail
+                const float32x4_t w0 = vaddq_f32(v0, vmulq_f32(a0, fx));
+                const float32x4_t w1 = vaddq_f32(v1, vmulq_f32(a1, fx));
+                const float32x4_t w2 = vaddq_f32(v2, vmulq_f32(a2, fx));
+
+                const uint32x4_t inside = vandq_u32(vandq_u32(vcgeq_f32(w0, zero), vcgeq_f32(w1, zero)), vcgeq_f32(w2, zero));
+
+                // lanes are all ones or zero, top bits summed
+                const uint32x4_t ones = vshrq_n_u32(inside, 31);
+                const uint32x2_t pairs = vadd_u32(vget_low_u32(ones), vget_high_u32(ones));
+                tested += vget_lane_u32(vpadd_u32(pairs, pairs), 0);
+
+                const float32x4_t z = vaddq_f32(vz, vmulq_f32(dz, fx));
+                const float32x4_t old = vld1q_f32(depth_row + pixel_x);
+                const uint32x4_t pass = vandq_u32(inside, vcltq_f32(z, old));
+
+                const uint32x2_t folded = vpmax_u32(vget_low_u32(pass), vget_high_u32(pass));
+                if (vget_lane_u32(vpmax_u32(folded, folded), 0) == 0)
+                    continue;
+
+                vst1q_f32(depth_row + pixel_x, vbslq_f32(pass, z, old));
+                vst1q_u32(passed, pass);
+
+                for (int k = 0; k < 4; k++)
                 {
-                    attroff(COLOR_PAIR(prev_color));
+                    if (passed[k])
+                    {
+                        written++;
+                        glyph_row[pixel_x + k] = triangle.color;
+                        material_row[pixel_x + k] = triangle.material;
+                    }
                 }
+            }
+        }
+#endif
+
+        // scalar tail with same operations as simd lanes
+        for (; pixel_x < row_end; pixel_x++)
+        {
+            const auto fx = static_cast<float>(pixel_x);
+
+            if (r0 + triangle.a[0] * fx >= 0.0f && r1 + triangle.a[1] * fx >= 0.0f && r2 + triangle.a[2] * fx >= 0.0f)
+            {
+                tested++;
 
-                if (color > 0)
+                if (const float z = rz + triangle.dzdx * fx; z < depth_row[pixel_x])
                 {
-                    attron(COLOR_PAIR(color));
+                    written++;
+                    depth_row[pixel_x] = z;
+                    glyph_row[pixel_x] = triangle.color;
+                    material_row[pixel_x] = triangle.material;
                 }
-
-                prev_color = color;
             }
+        }
+    }
 
-            ::printw("%c", pixel.c);
+    stats.tested += tested;
+    stats.written += written;
+
+    // max depth of touched blocks is taken again when next needed, blocks left stale only overestimate it
+    if (coarse && written > 0)
+    {
+        for (int by = y_start / static_cast<int>(HIZ_BLOCK_Y); by <= (y_end - 1) / static_cast<int>(HIZ_BLOCK_Y); by++)
+        {
+            uint8_t *dirty_row = block_dirty.data() + static_cast<size_t>(by) * blocks_x;
+            std::fill(dirty_row + x_start / static_cast<int>(HIZ_BLOCK_X), dirty_row + (x_end - 1) / static_cast<int>(HIZ_BLOCK_X) + 1, 1);
         }
+    }
+}
 
-        if (prev_color > 0)
+bool Buffer::occluded(const float z_min, const int x_start, const int x_end, const int y_start, const int y_end)
+{
+    for (int by = y_start / static_cast<int>(HIZ_BLOCK_Y); by <= (y_end - 1) / static_cast<int>(HIZ_BLOCK_Y); by++)
+    {
+        for (int bx = x_start / static_cast<int>(HIZ_BLOCK_X); bx <= (x_end - 1) / static_cast<int>(HIZ_BLOCK_X); bx++)
         {
-            attroff(COLOR_PAIR(prev_color));
+            const size_t b = static_cast<size_t>(by) * blocks_x + static_cast<size_t>(bx);
+
+            if (block_dirty[b])
+            {
+                const unsigned int px0 = static_cast<unsigned int>(bx) * HIZ_BLOCK_X, px1 = std::min(px0 + HIZ_BLOCK_X, x);
+                const unsigned int py0 = static_cast<unsigned int>(by) * HIZ_BLOCK_Y, py1 = std::min(py0 + HIZ_BLOCK_Y, y);
+
+                float max_depth = std::numeric_limits<float>::lowest();
+                for (unsigned int py = py0; py < py1; py++)
+                {
+                    const float *depth_row = depth.data() + static_cast<size_t>(py) * x;
+                    max_depth = std::max(max_depth, *std::max_element(depth_row + px0, depth_row + px1));
+                }
+
+                block_depth[b] = max_depth;
+                block_dirty[b] = 0;
+            }
+
+            // strict z-test, equal depth does not pass either
+            if (z_min < block_depth[b])
+                return false;
         }
     }
-}
\ No newline at end of file
+    return true;
+}
@@ -4,40 +4,56 @@
 
 #pragma once
 
-#include <optional>
+#include <cstdint>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
-#include <ncurses.h>
 #include <iostream>
 
+#include "entities/geometry/object.h"
 #include "utils/mathematics.h"
-#include "utils/algorithms.h"
+#include "utils/thread_pool.h"
+#include "config.h"
 
-// screen pixel
-class Pixel {
+// projection of triangle onto screen
+class Projection {
 public:
-    float z;                        // depth (z-coordinate)
-    char c;                         // character
-    std::optional<int> material;    // material index
+    Vec3 p1, p2, p3;    // vertices of triangle
+    char color;         // color of triangle
+    uint16_t material;  // material index or NO_MATERIAL
 
-    Pixel() : z(std::numeric_limits<float>::max()), c(' '), material(std::nullopt) {}
-    Pixel(const float z, const char c, const std::optional<int> material = std::nullopt) : z(z), c(c), material(material) {}
+    Projection(const Vec3 &p1, const Vec3 &p2, const Vec3 &p3, const char color, const uint16_t material = NO_MATERIAL) : p1(p1), p2(p2), p3(p3), color(color), material(material) {}
 };
 
-// projection of triangle onto screen
-class Projection {
+// triangle prepared for rasterization, everything in pixel units with pixel centers at integer coordinates
+class Triangle {
 public:
-    Vec3 p1, p2, p3; // vertices of triangle
-    char color;      // color of triangle
+    float a[3], b[3], c[3];     // edge functions e(px, py) = a * px + b * py + c, pixel is covered when all three >= 0
+    float z0, dzdx, dzdy;       // depth plane z(px, py) = z0 + dzdx * px + dzdy * py
+    float z_min;                // smallest vertex depth
+    int x0, x1, y0, y1;         // covered pixel bounding box [x0, x1) x [y0, y1) clamped to buffer
+    char color;
+    uint16_t material;
+};
 
-    Projection(const Vec3 &p1, const Vec3 &p2, const Vec3 &p3, const char color) : p1(p1), p2(p2), p3(p3), color(color) {}
+// work of rasterization, summed over tiles
+class RasterStats {
+public:
+    size_t triangles = 0;   // set up triangles covering pixel centers
+    size_t tested = 0;      // covered pixels z-tested
+    size_t written = 0;     // pixels that passed z-test
+    size_t rejected = 0;    // triangle and tile pairs skipped behind max depth of blocks
 
-    [[nodiscard]] Projection sort_x() const;
-    [[nodiscard]] float limit_y1(float x) const;
-    [[nodiscard]] float limit_y2(float x) const;
-    [[nodiscard]] Vec3 normal() const;
+    RasterStats &operator+=(const RasterStats &other)
+    {
+        triangles += other.triangles;
+        tested += other.tested;
+        written += other.written;
+        rejected += other.rejected;
+        return *this;
+    }
 };
 
 // screen buffer
@@ -46,17 +62,43 @@ public:
     unsigned int x, y;          // character buffer size
     float logical_x, logical_y; // logical buffer size
     float dx, dy;               // logical character size
-    std::vector<Pixel> pixels;  // pixel Buffer
+
+    // pixel planes, row major
+    std::vector<float> depth;           // z-coordinate, max float where empty
+    std::vector<char> glyphs;           // character
+    std::vector<uint16_t> materials;    // material index or NO_MATERIAL
 
     Buffer(unsigned int x, unsigned int y, float logical_x, float logical_y);
 
     void clear();
-    void draw_projection(const Projection &projection, char c, int material);
-    void printw() const;
+    void draw_projection(const Projection &projection, char c, uint16_t material, RasterStats *stats = nullptr);
+
+    // draws projections in given order, with pool screen tiles are drawn in parallel with identical result
+    void draw_projections(const std::vector<Projection> &projections, ThreadPool *pool = nullptr, RasterStats *stats = nullptr);
 
 private:
-    [[nodiscard]] int index_x(float real_x) const;
-    [[nodiscard]] int index_y(float real_y) const;
-    [[nodiscard]] float depth(const Projection &projection, const Vec3 &normal, int pixel_x, int pixel_y) const;
+    // pixel rectangle [x0, x1) x [y0, y1)
+    class Tile {
+    public:
+        int x0, x1, y0, y1;
+    };
+
+    // scratch of parallel drawing, capacity is kept between frames
+    std::vector<Triangle> triangles;            // set up projections
+    std::vector<std::vector<unsigned int>> bins;    // triangle indices per tile in submission order
+    std::vector<RasterStats> tile_stats;        // counters per tile, summed after drawing
+
+    // coarse depth, max of every HIZ_BLOCK_X x HIZ_BLOCK_Y block, blocks lie inside one tile
+    unsigned int blocks_x = 0, blocks_y = 0;
+    std::vector<float> block_depth;             // max depth of block, valid unless dirty
+    std::vector<uint8_t> block_dirty;           // block was written since its max was taken
+
+    // edge functions and depth gradient, false if triangle is degenerate or covers no pixel
+    [[nodiscard]] bool setup(const Projection &projection, char c, uint16_t material, Triangle &triangle) const;
+
+    // z-tests covered pixels inside tile, values of pixel depend only on its position so tiles match whole buffer drawing
+    void rasterize(const Triangle &triangle, const Tile &tile, RasterStats &stats);
 
+    // every pixel of rectangle already holds depth at most z_min, triangle can't pass z-test there
+    [[nodiscard]] bool occluded(float z_min, int x_start, int x_end, int y_start, int y_end);
 };
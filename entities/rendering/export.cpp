@@ -0,0 +1,95 @@
+/*
+ * export.cpp
+ */
+
+#include "export.h"
+
+#include <cstdio>
+
+#include "ansi.h"
+#include "utils/tools.h"
+
+// helpers
+
+// asciicast header, size of terminal that replays stream
+static std::string asciicast_header(const ExportOptions &options)
+{
+    return "{\"version\": 2, \"width\": " + std::to_string(options.width) +
+           ", \"height\": " + std::to_string(options.height) +
+           ", \"env\": {\"TERM\": \"xterm-256color\"}}\n";
+}
+
+// one output event with time in seconds
+static void asciicast_event(const double time, const std::string &data, std::string &line)
+{
+    char stamp[32];
+    std::snprintf(stamp, sizeof(stamp), "[%.6f, \"o\", \"", time);
+
+    line.clear();
+    line += stamp;
+    append_json(line, data);
+    line += "\"]\n";
+}
+
+// Exporter methods
+
+bool Exporter::run(const Object &obj, const Camera &start, const Light &light, const ExportOptions &options, ThreadPool &pool, std::ostream &out)
+{
+    const float logical_y = 2.0f;
+    const float logical_x = logical_y * static_cast<float>(options.width) / (static_cast<float>(options.height) * CHAR_ASPECT_RATIO);
+
+    Buffer buf(options.width, options.height, logical_x, logical_y);
+    Camera cam = start;
+
+    Renderer renderer(options.front_to_back);
+    renderer.reserve(obj);
+
+    AnsiEncoder encoder(options.color_support ? obj.materials : std::vector<Material>{}, options.base, options.plain);
+    std::string frame, line;
+
+    // hidden cursor and clean screen before first frame
+    const std::string prologue = "\x1b[?25l\x1b[2J";
+    const std::string epilogue = "\x1b[0m\x1b[" + std::to_string(options.height) + ";1H\x1b[?25h\n";
+
+    if (options.format == ExportFormat::Asciicast)
+    {
+        out << asciicast_header(options);
+    }
+
+    for (unsigned int k = 0; k < options.frames && out; k++)
+    {
+        // same steps as interactive animation at nominal frame rate
+        if (k > 0)
+        {
+            if (options.animate_altitude)
+                cam.rotate_down(options.speed_altitude * FRAME_DURATION);
+            if (options.animate_azimuth)
+                cam.rotate_left(options.speed_azimuth * FRAME_DURATION);
+        }
+
+        buf.clear();
+        renderer.render(buf, obj, cam, light, options.static_light, options.color_support, &pool);
+
+        frame.clear();
+        if (k == 0)
+            frame += prologue;
+
+        encoder.encode(buf, frame);
+
+        if (k + 1 == options.frames)
+            frame += epilogue;
+
+        if (options.format == ExportFormat::Asciicast)
+        {
+            asciicast_event(static_cast<double>(k) * FRAME_DURATION, frame, line);
+            out.write(line.data(), static_cast<std::streamsize>(line.size()));
+        }
+        else
+        {
+            out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        }
+    }
+
+    out.flush();
+    return static_cast<bool>(out);
+}
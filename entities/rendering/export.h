@@ -0,0 +1,49 @@
+/*
+ * export.h
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "buffer.h"
+#include "renderer.h"
+#include "entities/geometry/object.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+#include "utils/thread_pool.h"
+#include "config.h"
+
+enum class ExportFormat {
+    Ansi,       // escape sequences as written to terminal, each frame diffs previous one
+    Asciicast   // asciicast v2 recording, one output event per frame
+};
+
+// parameters of headless frame stream
+class ExportOptions {
+public:
+    unsigned int frames = 0;
+    unsigned int width = BENCH_WIDTH;       // buffer size in characters
+    unsigned int height = BENCH_HEIGHT;
+    ExportFormat format = ExportFormat::Ansi;
+    bool static_light = false;
+    bool color_support = false;
+    bool front_to_back = true;              // see Renderer
+
+    // animation as in interactive mode, frames are FRAME_DURATION apart
+    bool animate_altitude = false;
+    bool animate_azimuth = false;
+    float speed_altitude = ANIMATION_STEP_ALTITUDE;     // deg/s
+    float speed_azimuth = ANIMATION_STEP_AZIMUTH;       // deg/s
+
+    // sgr of frame and of cells without material, see AnsiEncoder
+    std::string base = "\x1b[0m";
+    std::string plain = "\x1b[39m";
+};
+
+class Exporter {
+public:
+    // renders frames of animation from camera and streams them without terminal, false if output failed
+    static bool run(const Object &obj, const Camera &start, const Light &light, const ExportOptions &options, ThreadPool &pool, std::ostream &out);
+};
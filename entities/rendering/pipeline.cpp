@@ -0,0 +1,102 @@
+/*
+ * pipeline.cpp
+ */
+
+#include "pipeline.h"
+
+#include <chrono>
+
+#include "utils/scoped_timer.h"
+
+RenderPipeline::RenderPipeline(const Light &light, const bool static_light, const bool color_support, const bool front_to_back, ThreadPool &pool)
+    : light(light), static_light(static_light), color_support(color_support), pool(pool), renderer(front_to_back), requests(FrameRequest{}), frames(Frame{})
+{
+    if (wake.fd() < 0)
+    {
+        std::cerr << "warning: no frame notifier, frames are shown on next event" << std::endl;
+    }
+
+    worker = std::thread(&RenderPipeline::run, this);
+}
+
+RenderPipeline::~RenderPipeline()
+{
+    stopping.store(true);
+    posted.fetch_add(1);
+    posted.notify_one();
+    worker.join();
+}
+
+unsigned long RenderPipeline::request(std::shared_ptr<const Object> obj, const Camera &cam, const unsigned int x, const unsigned int y, const float logical_x, const float logical_y)
+{
+    FrameRequest &next = requests.back();
+    next.obj = std::move(obj);
+    next.cam = cam;
+    next.x = x;
+    next.y = y;
+    next.logical_x = logical_x;
+    next.logical_y = logical_y;
+    next.id = ++last_id;
+    requests.publish();
+
+    posted.fetch_add(1);
+    posted.notify_one();
+    return last_id;
+}
+
+const Frame *RenderPipeline::take()
+{
+    // notifier is only a hint, mailbox tells whether frame is there
+    wake.drain();
+
+    return frames.fetch() ? &frames.front() : nullptr;
+}
+
+void RenderPipeline::run()
+{
+    while (true)
+    {
+        // counter read before mailbox, request published after it changes counter and ends wait
+        const unsigned int seen = posted.load();
+
+        if (stopping.load())
+            return;
+
+        if (!requests.fetch())
+        {
+            posted.wait(seen);
+            continue;
+        }
+
+        const FrameRequest &view = requests.front();
+        Frame &frame = frames.back();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        if (frame.buf.x != view.x || frame.buf.y != view.y || frame.buf.logical_x != view.logical_x || frame.buf.logical_y != view.logical_y)
+        {
+            frame.buf = Buffer(view.x, view.y, view.logical_x, view.logical_y);
+        }
+
+        // scratch grows once per model, not inside first frame of each one
+        if (view.obj.get() != reserved)
+        {
+            renderer.reserve(*view.obj);
+            reserved = view.obj.get();
+        }
+
+        frame.stats.clear = 0.0;
+        {
+            ScopedTimer timer(frame.stats.clear);
+            frame.buf.clear();
+        }
+        renderer.render(frame.buf, *view.obj, view.cam, light, static_light, color_support, &pool, &frame.stats);
+
+        frame.cam = view.cam;
+        frame.id = view.id;
+        frame.cost = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        frames.publish();
+
+        wake.notify();
+    }
+}
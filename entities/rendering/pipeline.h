@@ -0,0 +1,79 @@
+/*
+ * pipeline.h
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "buffer.h"
+#include "renderer.h"
+#include "entities/geometry/object.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+#include "utils/mailbox.h"
+#include "utils/notifier.h"
+#include "utils/thread_pool.h"
+
+// view to render, buffer size included so that resize reaches render thread with it
+class FrameRequest {
+public:
+    std::shared_ptr<const Object> obj;      // model to draw, replaced while model is still loading
+    Camera cam;
+    unsigned int x = 0, y = 0;              // character buffer size
+    float logical_x = 0.0f, logical_y = 0.0f;
+    unsigned long id = 0;                   // increasing number of request
+};
+
+// rendered buffer with view it shows
+class Frame {
+public:
+    Buffer buf;
+    Camera cam;
+    float cost = 0.0f;                      // seconds of rendering
+    RenderStats stats;                      // stages and work of rendering
+    unsigned long id = 0;                   // request it answers
+
+    Frame() : buf(1, 1, 1.0f, 1.0f) {}
+};
+
+// render stage on own thread, while caller presents one frame next is drawn
+// newest request wins, finished frames come back through mailbox and wake notifier
+class RenderPipeline {
+public:
+    RenderPipeline(const Light &light, bool static_light, bool color_support, bool front_to_back, ThreadPool &pool);
+    ~RenderPipeline();
+
+    RenderPipeline(const RenderPipeline &) = delete;
+    RenderPipeline &operator=(const RenderPipeline &) = delete;
+
+    // asks for frame of model in view, returns its id
+    unsigned long request(std::shared_ptr<const Object> obj, const Camera &cam, unsigned int x, unsigned int y, float logical_x, float logical_y);
+
+    // newest finished frame not taken yet, nullptr if none, frame stays valid until next take
+    [[nodiscard]] const Frame *take();
+
+    // readable file descriptor while finished frame waits, for waiting on input together with frames
+    [[nodiscard]] int notifier() const { return wake.fd(); }
+
+private:
+    const Light &light;
+    const bool static_light, color_support;
+    ThreadPool &pool;
+    Renderer renderer;                      // used by render thread only
+    const Object *reserved = nullptr;       // model renderer scratch is sized for, render thread only
+
+    Mailbox<FrameRequest> requests;
+    Mailbox<Frame> frames;
+    unsigned long last_id = 0;
+
+    std::atomic<unsigned int> posted{0};    // bumped on every request and on stop, render thread waits on it
+    std::atomic<bool> stopping{false};
+    Notifier wake;                          // readable while finished frame waits
+
+    std::thread worker;
+
+    void run();
+};
@@ -0,0 +1,34 @@
+/*
+ * presenter.h
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "buffer.h"
+
+// output backend of interactive mode, writes frames to terminal
+class Presenter {
+public:
+    unsigned long cells = 0;    // cells written by last present
+    unsigned long bytes = 0;    // bytes sent to terminal by last flush, 0 if not measurable
+
+    virtual ~Presenter() = default;
+
+    // writes cells of buffer changed since previous frame, nothing reaches terminal before flush
+    virtual void present(const Buffer &buf) = 0;
+
+    // text over frame from start of row (hud), row is rewritten by next present
+    virtual void overlay(unsigned int row, std::string_view text) = 0;
+
+    // sends frame to terminal
+    virtual void flush() = 0;
+
+    // forget previous frame, next present writes every cell
+    virtual void invalidate() = 0;
+
+    // materials of model changed, colors of backend are set up elsewhere by default
+    virtual void set_materials(const std::vector<Material> &) { invalidate(); }
+};
@@ -0,0 +1,115 @@
+/*
+ * profiler.cpp
+ */
+
+#include "profiler.h"
+
+#include <fstream>
+#include <iomanip>
+
+// FrameProfile methods
+
+void FrameProfile::set_render(const double render_ms, const RenderStats &stats)
+{
+    render = render_ms;
+    clear = stats.clear;
+    transform = stats.transform;
+    cull = stats.cull;
+    raster = stats.raster;
+
+    faces = stats.faces;
+    submitted = stats.submitted;
+    rasterized = stats.pixels.triangles;
+    tested = stats.pixels.tested;
+    written = stats.pixels.written;
+    rejected = stats.pixels.rejected;
+}
+
+// Profiler methods
+
+void Profiler::record(FrameProfile profile)
+{
+    profile.frame = frames.total();
+    frames.push(profile);
+}
+
+FrameProfile Profiler::average(const size_t count) const
+{
+    FrameProfile mean;
+
+    const size_t n = std::min(count, frames.size());
+    size_t rendered = 0;
+
+    for (size_t age = 0; age < n; age++)
+    {
+        const FrameProfile &p = frames.newest(age);
+
+        mean.present += p.present;
+        mean.cells += p.cells;
+        mean.bytes += p.bytes;
+
+        if (p.cached)
+            continue;
+
+        rendered++;
+        mean.render += p.render;
+        mean.clear += p.clear;
+        mean.transform += p.transform;
+        mean.cull += p.cull;
+        mean.raster += p.raster;
+        mean.faces += p.faces;
+        mean.submitted += p.submitted;
+        mean.rasterized += p.rasterized;
+        mean.tested += p.tested;
+        mean.written += p.written;
+        mean.rejected += p.rejected;
+    }
+
+    if (n == 0)
+        return mean;
+
+    mean.frame = frames.newest(0).frame;
+    mean.cached = rendered == 0;
+    mean.present /= static_cast<double>(n);
+    mean.cells /= n;
+    mean.bytes /= n;
+
+    if (rendered == 0)
+        return mean;
+
+    const auto r = static_cast<double>(rendered);
+    mean.render /= r;
+    mean.clear /= r;
+    mean.transform /= r;
+    mean.cull /= r;
+    mean.raster /= r;
+    mean.faces /= rendered;
+    mean.submitted /= rendered;
+    mean.rasterized /= rendered;
+    mean.tested /= rendered;
+    mean.written /= rendered;
+    mean.rejected /= rendered;
+    return mean;
+}
+
+bool Profiler::dump(const std::filesystem::path &filename) const
+{
+    std::ofstream out(filename);
+    if (!out)
+        return false;
+
+    out << "frame,cached,render_ms,clear_ms,transform_ms,cull_ms,raster_ms,present_ms,"
+           "faces,submitted,rasterized,tested,written,rejected,cells,bytes\n";
+    out << std::fixed << std::setprecision(3);
+
+    for (size_t age = frames.size(); age-- > 0;)
+    {
+        const FrameProfile &p = frames.newest(age);
+        out << p.frame << ',' << (p.cached ? 1 : 0) << ','
+            << p.render << ',' << p.clear << ',' << p.transform << ',' << p.cull << ',' << p.raster << ',' << p.present << ','
+            << p.faces << ',' << p.submitted << ',' << p.rasterized << ',' << p.tested << ',' << p.written << ',' << p.rejected << ','
+            << p.cells << ',' << p.bytes << '\n';
+    }
+
+    return static_cast<bool>(out.flush());
+}
@@ -0,0 +1,54 @@
+/*
+ * profiler.h
+ */
+
+#pragma once
+
+#include <filesystem>
+
+#include "renderer.h"
+#include "utils/ring.h"
+#include "config.h"
+
+// measured frame of interactive mode, times in milliseconds
+class FrameProfile {
+public:
+    unsigned long frame = 0;    // number of presented frame
+    bool cached = false;        // shown from turntable cache, no render stages
+
+    double render = 0.0;        // whole render thread work
+    double clear = 0.0;
+    double transform = 0.0;
+    double cull = 0.0;
+    double raster = 0.0;
+    double present = 0.0;       // diff, overlays and flush to terminal
+
+    size_t faces = 0;           // faces of drawn level
+    size_t submitted = 0;       // faces left after culling
+    size_t rasterized = 0;      // submitted faces covering pixel centers
+    size_t tested = 0;          // covered pixels z-tested
+    size_t written = 0;         // pixels that passed z-test
+    size_t rejected = 0;        // triangle and tile pairs skipped behind drawn pixels
+
+    unsigned long cells = 0;    // changed cells written
+    unsigned long bytes = 0;    // bytes sent to terminal
+
+    // render part of profile from stats of render thread
+    void set_render(double render_ms, const RenderStats &stats);
+};
+
+// keeps last PROFILE_FRAMES frames, cheap enough to stay on
+class Profiler {
+public:
+    // numbers frame and keeps it, oldest frame is dropped when full
+    void record(FrameProfile profile);
+
+    // mean of newest frames, rendered ones only for render fields
+    [[nodiscard]] FrameProfile average(size_t frames = PROFILE_HUD_FRAMES) const;
+
+    // kept frames oldest first as csv, false if file can't be written
+    [[nodiscard]] bool dump(const std::filesystem::path &filename) const;
+
+private:
+    Ring<FrameProfile, PROFILE_FRAMES> frames;
+};
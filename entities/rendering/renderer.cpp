@@ -4,88 +4,340 @@
 
 #include "renderer.h"
 
-char Renderer::luminance_char(const Vec3 &normal, const Vec3 &light, const std::string &scale)
+#include <chrono>
+#include <iterator>
+
+using SteadyClock = std::chrono::steady_clock;
+
+// milliseconds since start, updates start for next stage
+static double lap(SteadyClock::time_point &start)
+{
+    const auto now = SteadyClock::now();
+    const double ms = std::chrono::duration<double, std::milli>(now - start).count();
+    start = now;
+    return ms;
+}
+
+char Renderer::luminance_char(const Vec3 &normal, const Vec3 &light)
 {
+    constexpr int last = static_cast<int>(std::size(CHARS_LUM)) - 2;  // terminating zero is not a level
+
     const float sim = (Vec3::cosine_similarity(normal, light) + 1.0f) * 0.5f;
-    const int idx = std::clamp(static_cast<int>(std::round(sim * static_cast<float>(scale.size() - 1))), 0, static_cast<int>(scale.size() - 1));
-    return scale[idx];
+    const int idx = std::clamp(static_cast<int>(std::round(sim * static_cast<float>(last))), 0, last);
+    return CHARS_LUM[idx];
 }
 
-void Renderer::render(Buffer &buf, const Object &obj, const Camera &cam, const Light  &light, bool static_light, bool color_support)
+void Renderer::bake_light(Mesh &mesh, const Light &light)
 {
-    const float az_cos = std::cos(cam.azimuth);
-    const float az_sin = std::sin(cam.azimuth);
-    const float al_cos = std::cos(cam.altitude);
-    const float al_sin = std::sin(cam.altitude);
-
-    // pre-computed rotations
-    auto rot_y = [az_cos, az_sin](const Vec3 &v) {
-        return Vec3::rotate_y(v, std::atan2(-az_sin, az_cos));
-    };
+    const size_t fcount = mesh.face_count();
+    mesh.luminance.resize(fcount);
 
-    auto rot_x = [al_cos, al_sin](const Vec3 &v) {
-        return Vec3::rotate_x(v, std::atan2(-al_sin, al_cos));
-    };
+    for (size_t f = 0; f < fcount; f++)
+    {
+        mesh.luminance[f] = luminance_char(mesh.normal(f), light.direction);
+    }
+}
 
-    const float lx = buf.logical_x;
-    const float ly = buf.logical_y;
+const Mesh &Renderer::select_level(const Buffer &buf, const Object &obj, const Camera &cam)
+{
+    // screen offset of object space distance d is 0.5 * zoom * d logical units
+    const float limit = LOD_MAX_ERROR * std::min(buf.dx, buf.dy);
+    const Mesh *level = &obj.mesh;
 
-    // first pass - rotate, project, collect bounds
-    const size_t vcount = obj.vertices.size();
+    for (const auto &lod : obj.lods)
+    {
+        if (0.5f * cam.zoom * lod.error > limit)
+            break;
+
+        level = &lod.mesh;
+    }
 
-    std::vector<Vec3> rverts(vcount);   // rotated vertices
-    std::vector<Vec3> sverts(vcount);   // screen coords (without offset)
+    return *level;
+}
 
-    float min_x = std::numeric_limits<float>::max();
-    float max_x = -std::numeric_limits<float>::max();
-    float min_y = std::numeric_limits<float>::max();
-    float max_y = -std::numeric_limits<float>::max();
+size_t Renderer::select_level(const Buffer &buf, const ClusterFile &stream, const Camera &cam)
+{
+    const float limit = LOD_MAX_ERROR * std::min(buf.dx, buf.dy);
+    size_t level = 0;
 
-    for (size_t i = 0; i < vcount; i++)
+    for (size_t l = 1; l < stream.levels.size(); l++)
     {
-        const Vec3 rv = rot_x(rot_y(obj.vertices[i]));
-        rverts[i] = rv;
+        if (0.5f * cam.zoom * stream.levels[l].error > limit)
+            break;
+
+        level = l;
+    }
 
-        const Vec3 sv = Vec3::to_screen(rv, cam.zoom, lx, ly);
-        sverts[i] = sv;
+    return level;
+}
 
-        min_x = std::min(min_x, sv.x);
-        max_x = std::max(max_x, sv.x);
-        min_y = std::min(min_y, sv.y);
-        max_y = std::max(max_y, sv.y);
+void Renderer::reserve(const Object &obj)
+{
+    // clusters are transformed one at a time, projections grow with visible part
+    if (obj.stream)
+    {
+        verts.resize(std::max(obj.stream->max_vertices, obj.stream->hull_x.size()));
+        return;
     }
 
-    // offset that centers the bounding box in logical space
-    const float off_x = 0.0f;
-    const float off_y = (ly - (max_y - min_y)) * 0.5f - min_y;
-    const Vec3 offset(off_x, off_y, 0.0f);
+    size_t vcount = obj.mesh.vertex_count();
+    size_t fcount = obj.mesh.face_count();
 
-    // second pass - draw faces
-    for (const auto &face : obj.faces)
+    for (const auto &lod : obj.lods)
     {
-        const Vec3 &rv1 = rverts[face.indices[0]];
-        const Vec3 &rv2 = rverts[face.indices[1]];
-        const Vec3 &rv3 = rverts[face.indices[2]];
+        vcount = std::max(vcount, lod.mesh.vertex_count());
+        fcount = std::max(fcount, lod.mesh.face_count());
+    }
+
+    verts.resize(vcount);
+    projections.reserve(fcount / 2);
+}
+
+template<typename Node>
+bool Renderer::in_view(const Node &node, const ViewTransform &view, const Buffer &buf, const Vec3 &offset)
+{
+    const auto &m = view.rotation.m;
+    const float half_zoom = 0.5f * view.zoom;
+
+    // whole cone faces away from camera, view direction is last row of rotation
+    if (node.axis[0] * m[2][0] + node.axis[1] * m[2][1] + node.axis[2] * m[2][2] > node.cutoff)
+        return false;
+
+    // screen rectangle of projected bounding box outside logical viewport
+    const float c[3] = {(node.min[0] + node.max[0]) * 0.5f, (node.min[1] + node.max[1]) * 0.5f, (node.min[2] + node.max[2]) * 0.5f};
+    const float e[3] = {(node.max[0] - node.min[0]) * 0.5f, (node.max[1] - node.min[1]) * 0.5f, (node.max[2] - node.min[2]) * 0.5f};
+
+    const float center_x = 0.5f * buf.logical_x + half_zoom * (m[0][0] * c[0] + m[0][1] * c[1] + m[0][2] * c[2]) + offset.x;
+    const float center_y = 0.5f * buf.logical_y - half_zoom * (m[1][0] * c[0] + m[1][1] * c[1] + m[1][2] * c[2]) + offset.y;
+    const float extent_x = half_zoom * (std::abs(m[0][0]) * e[0] + std::abs(m[0][1]) * e[1] + std::abs(m[0][2]) * e[2]);
+    const float extent_y = half_zoom * (std::abs(m[1][0]) * e[0] + std::abs(m[1][1]) * e[1] + std::abs(m[1][2]) * e[2]);
 
-        // back-face culling in camera space
-        Vec3 normal_cam = Vec3::cross(rv2 - rv1, rv3 - rv1).normalize();
+    return !(center_x + extent_x < 0.0f || center_x - extent_x > buf.logical_x ||
+             center_y + extent_y < 0.0f || center_y - extent_y > buf.logical_y);
+}
+
+template<typename Node>
+float Renderer::depth(const Node &node, const ViewTransform &view)
+{
+    const auto &m = view.rotation.m;
+    return m[2][0] * (node.min[0] + node.max[0]) + m[2][1] * (node.min[1] + node.max[1]) + m[2][2] * (node.min[2] + node.max[2]);
+}
+
+template<Renderer::Shading shading, bool color, typename Faces>
+void Renderer::collect(const Buffer &buf, const Faces &mesh, const ViewTransform &view, const Vec3 &offset, const Light &light)
+{
+    const size_t fcount = mesh.face_count();
+
+    // back-face test, shading and projection of one face
+    auto shade = [&](const size_t f) {
+        const unsigned int i1 = mesh.indices[3 * f];
+        const unsigned int i2 = mesh.indices[3 * f + 1];
+        const unsigned int i3 = mesh.indices[3 * f + 2];
+
+        const Vec3 rv1(verts.rx[i1], verts.ry[i1], verts.rz[i1]);
+        const Vec3 rv2(verts.rx[i2], verts.ry[i2], verts.rz[i2]);
+        const Vec3 rv3(verts.rx[i3], verts.ry[i3], verts.rz[i3]);
+
+        // back-face culling in camera space, sign does not need unit normal
+        const Vec3 normal_cam = Vec3::cross(rv2 - rv1, rv3 - rv1);
 
         if (normal_cam.z >= 0.0f)
         {
-            continue;
+            return;
         }
 
-        const Vec3 normal_view = -normal_cam;
-
         // screen coordinates with centering offset
-        const Vec3 s1 = sverts[face.indices[0]] + offset;
-        const Vec3 s2 = sverts[face.indices[1]] + offset;
-        const Vec3 s3 = sverts[face.indices[2]] + offset;
+        const Vec3 s1 = Vec3(verts.sx[i1], verts.sy[i1], verts.sz[i1]) + offset;
+        const Vec3 s2 = Vec3(verts.sx[i2], verts.sy[i2], verts.sz[i2]) + offset;
+        const Vec3 s3 = Vec3(verts.sx[i3], verts.sy[i3], verts.sz[i3]) + offset;
 
         // shading
-        const Vec3 n_light = static_light ? Vec3::cross(obj.vertices[face.indices[1]] - obj.vertices[face.indices[0]], obj.vertices[face.indices[2]] - obj.vertices[face.indices[0]]).normalize() : normal_view;
-        const char lum = luminance_char(n_light, light.direction, CHARS_LUM);
+        char lum;
+        if constexpr (shading == Shading::Baked)
+            lum = mesh.luminance[f];
+        else if constexpr (shading == Shading::Static)
+            lum = luminance_char(mesh.normal(f), light.direction);
+        else
+            lum = luminance_char(-normal_cam.normalize(), light.direction);
 
-        buf.draw_projection(Projection(s1, s2, s3, lum), lum, (color_support && face.material) ? *face.material : -1);
+        if constexpr (color)
+            projections.emplace_back(s1, s2, s3, lum, mesh.materials[f]);
+        else
+            projections.emplace_back(s1, s2, s3, lum, NO_MATERIAL);
+    };
+
+    if (mesh.nodes.empty())
+    {
+        for (size_t f = 0; f < fcount; f++)
+            shade(f);
     }
-}
\ No newline at end of file
+    else
+    {
+        // depth first, leaves in face order or with nearer child on top
+        stack.assign(1, 0);
+        while (!stack.empty())
+        {
+            const BvhNode &node = mesh.nodes[stack.back()];
+            stack.pop_back();
+
+            if (!in_view(node, view, buf, offset))
+                continue;
+
+            if (node.count == 0)
+            {
+                unsigned int near = node.first, far = node.first + 1;
+
+                if (front_to_back && depth(mesh.nodes[far], view) < depth(mesh.nodes[near], view))
+                    std::swap(near, far);
+
+                stack.push_back(far);
+                stack.push_back(near);
+                continue;
+            }
+
+            for (size_t f = node.first; f < node.first + node.count; f++)
+                shade(f);
+        }
+    }
+
+}
+
+template<typename Faces>
+void Renderer::collect(const Shading shading, const bool color, const Buffer &buf, const Faces &mesh, const ViewTransform &view, const Vec3 &offset, const Light &light)
+{
+    switch (shading)
+    {
+        case Shading::Dynamic:
+            color ? collect<Shading::Dynamic, true>(buf, mesh, view, offset, light) : collect<Shading::Dynamic, false>(buf, mesh, view, offset, light);
+            break;
+        case Shading::Static:
+            color ? collect<Shading::Static, true>(buf, mesh, view, offset, light) : collect<Shading::Static, false>(buf, mesh, view, offset, light);
+            break;
+        case Shading::Baked:
+            color ? collect<Shading::Baked, true>(buf, mesh, view, offset, light) : collect<Shading::Baked, false>(buf, mesh, view, offset, light);
+            break;
+    }
+}
+
+void Renderer::render(Buffer &buf, const Object &obj, const Camera &cam, const Light  &light, bool static_light, bool color_support, ThreadPool *pool, RenderStats *stats)
+{
+    if (obj.stream)
+    {
+        render_streamed(buf, *obj.stream, cam, light, static_light, color_support, pool, stats);
+        return;
+    }
+
+    const Mesh &mesh = select_level(buf, obj, cam);
+    auto start = stats ? SteadyClock::now() : SteadyClock::time_point{};
+
+    // first pass - rotate, project, collect bounds
+    const ViewTransform view(cam, buf.logical_x, buf.logical_y);
+
+    const Bounds bounds = transform_project(mesh, view, verts);
+
+    // offset that centers the bounding box in logical space
+    const float off_x = 0.0f;
+    const float off_y = (buf.logical_y - (bounds.max_y - bounds.min_y)) * 0.5f - bounds.min_y;
+    const Vec3 offset(off_x, off_y, 0.0f);
+
+    if (stats)
+        stats->transform = lap(start);
+
+    // second pass - cull and shade faces, mode is fixed for whole frame
+    const Shading shading = !static_light ? Shading::Dynamic : mesh.luminance.size() == mesh.face_count() ? Shading::Baked : Shading::Static;
+
+    projections.clear();
+    collect(shading, color_support, buf, mesh, view, offset, light);
+
+    if (stats)
+        stats->cull = lap(start);
+
+    // third pass - rasterize in submission order
+    if (stats)
+        stats->pixels = RasterStats{};
+
+    buf.draw_projections(projections, pool, stats ? &stats->pixels : nullptr);
+
+    if (stats)
+    {
+        stats->raster = lap(start);
+        stats->faces = mesh.face_count();
+        stats->submitted = projections.size();
+    }
+}
+
+void Renderer::render_streamed(Buffer &buf, const ClusterFile &stream, const Camera &cam, const Light &light, bool static_light, bool color_support, ThreadPool *pool, RenderStats *stats)
+{
+    const ClusterLevel &level = stream.levels[select_level(buf, stream, cam)];
+    auto start = stats ? SteadyClock::now() : SteadyClock::time_point{};
+
+    // scratch fits hull and biggest cluster, no allocation once reserved
+    verts.resize(std::max(stream.max_vertices, stream.hull_x.size()));
+
+    // hull stands in for vertices of level when centering, they are not all resident
+    const ViewTransform view(cam, buf.logical_x, buf.logical_y);
+
+    const Bounds bounds = transform_project(stream.hull_x.data(), stream.hull_y.data(), stream.hull_z.data(), stream.hull_x.size(), view,
+                                            verts.rx.data(), verts.ry.data(), verts.rz.data(), verts.sx.data(), verts.sy.data(), verts.sz.data());
+
+    const float off_x = 0.0f;
+    const float off_y = (buf.logical_y - (bounds.max_y - bounds.min_y)) * 0.5f - bounds.min_y;
+    const Vec3 offset(off_x, off_y, 0.0f);
+
+    // clusters of level worth paging in, nearest first
+    visible.clear();
+    for (unsigned int c = level.first; c < level.first + level.count; c++)
+    {
+        if (in_view(stream.clusters[c], view, buf, offset))
+            visible.push_back(c);
+    }
+
+    if (front_to_back)
+    {
+        std::ranges::stable_sort(visible, [&](const unsigned int a, const unsigned int b) {
+            return depth(stream.clusters[a], view) < depth(stream.clusters[b], view);
+        });
+    }
+
+    stream.prefetch(visible);
+
+    double transform = stats ? lap(start) : 0.0, cull = 0.0;
+
+    // cluster by cluster - page in, rotate and project, cull and shade, light is never baked into sidecar
+    const Shading shading = static_light ? Shading::Static : Shading::Dynamic;
+
+    projections.clear();
+    for (const unsigned int c : visible)
+    {
+        ClusterView cluster;
+        if (!stream.acquire(c, cluster))
+            continue;
+
+        transform_project(cluster.x, cluster.y, cluster.z, cluster.vertex_count(), view,
+                          verts.rx.data(), verts.ry.data(), verts.rz.data(), verts.sx.data(), verts.sy.data(), verts.sz.data());
+
+        if (stats)
+            transform += lap(start);
+
+        collect(shading, color_support, buf, cluster, view, offset, light);
+
+        if (stats)
+            cull += lap(start);
+    }
+
+    if (stats)
+    {
+        stats->transform = transform;
+        stats->cull = cull;
+        stats->pixels = RasterStats{};
+    }
+
+    buf.draw_projections(projections, pool, stats ? &stats->pixels : nullptr);
+
+    if (stats)
+    {
+        stats->raster = lap(start);
+        stats->faces = level.face_count;
+        stats->submitted = projections.size();
+    }
+}
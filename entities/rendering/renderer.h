@@ -5,18 +5,77 @@
 #pragma once
 
 #include "buffer.h"
+#include "transform.h"
 #include "entities/geometry/object.h"
+#include "entities/geometry/stream.h"
 #include "entities/view/camera.h"
 #include "entities/view/light.h"
 #include "utils/algorithms.h"
 #include "config.h"
 
+// time of render stages in milliseconds and work counters, filled when requested
+class RenderStats {
+public:
+    double transform = 0.0; // rotation, projection and bounds of vertices
+    double cull = 0.0;      // back-face culling and shading
+    double raster = 0.0;    // triangle setup, binning and drawing
+    double clear = 0.0;     // buffer reset, timed by caller
+
+    size_t faces = 0;       // faces of drawn level
+    size_t submitted = 0;   // faces left after culling
+    RasterStats pixels;     // rasterized triangles and z-tested pixels
+};
+
+// draws objects into buffers, keeps per frame scratch between calls
 class Renderer {
 public:
-    // renders object into buffer with given view parameters
-    static void render(Buffer &buf, const Object &obj, const Camera &cam, const Light  &light, bool static_light, bool color_support) ;
+    // front to back draws nearer child of each hierarchy node first, so that covered faces are rejected before rasterization
+    explicit Renderer(const bool front_to_back = true) : front_to_back(front_to_back) {}
+
+    // sizes scratch for biggest level of object, later frames of it do not allocate
+    void reserve(const Object &obj);
+
+    // renders object into buffer with given view parameters, rasterizes screen tiles on pool if given
+    void render(Buffer &buf, const Object &obj, const Camera &cam, const Light  &light, bool static_light, bool color_support, ThreadPool *pool = nullptr, RenderStats *stats = nullptr);
+
+    // coarsest level of detail whose vertex error stays under LOD_MAX_ERROR characters at camera zoom
+    static const Mesh &select_level(const Buffer &buf, const Object &obj, const Camera &cam);
+
+    // same over levels of streamed object, index into its levels
+    static size_t select_level(const Buffer &buf, const ClusterFile &stream, const Camera &cam);
+
+    // caches luminance character of every face for light fixed to object, used by static light rendering
+    static void bake_light(Mesh &mesh, const Light &light);
 
 private:
-    // returns luminance character based on angle between normal and light
-    static char luminance_char(const Vec3 &normal, const Vec3 &light, const std::string &scale = CHARS_LUM);
+    bool front_to_back;
+    ProjectedVertices verts;                // transformed vertices of drawn level
+    std::vector<Projection> projections;    // visible faces in submission order
+    std::vector<unsigned int> stack;        // nodes of hierarchy waiting for visit
+    std::vector<unsigned int> visible;      // clusters of streamed level in drawing order
+
+    // source of face luminance, chosen once per frame
+    enum class Shading { Dynamic, Static, Baked };
+
+    // culls and shades faces of mesh or cluster into projections, one instance per mode keeps per face loop free of mode tests
+    template<Shading shading, bool color, typename Faces>
+    void collect(const Buffer &buf, const Faces &mesh, const ViewTransform &view, const Vec3 &offset, const Light &light);
+
+    // picks instance of collect for mode of frame
+    template<typename Faces>
+    void collect(Shading shading, bool color, const Buffer &buf, const Faces &mesh, const ViewTransform &view, const Vec3 &offset, const Light &light);
+
+    // streamed object - clusters of level inside viewport are paged in and collected one after another
+    void render_streamed(Buffer &buf, const ClusterFile &stream, const Camera &cam, const Light &light, bool static_light, bool color_support, ThreadPool *pool, RenderStats *stats);
+
+    // hierarchy node or cluster whose normal cone faces camera and whose projected box touches logical viewport
+    template<typename Node>
+    static bool in_view(const Node &node, const ViewTransform &view, const Buffer &buf, const Vec3 &offset);
+
+    // depth of box center along view direction, doubled, smaller is nearer
+    template<typename Node>
+    static float depth(const Node &node, const ViewTransform &view);
+
+    // returns character of CHARS_LUM based on angle between normal and light
+    static char luminance_char(const Vec3 &normal, const Vec3 &light);
 };
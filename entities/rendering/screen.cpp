@@ -0,0 +1,171 @@
+/*
+ * screen.cpp
+ */
+
+#include "screen.h"
+
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <string_view>
+#include <unistd.h>
+
+Screen::Screen(const bool color_support) : color_support(color_support)
+{
+    // ncurses flushes its own buffer with write(2) to descriptor of its output file, so no stdio stream sees it
+    // counter of this thread only, sidecars and wakeups written by loader and render threads are left out
+    io = ::open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+    written = write_counter();
+}
+
+Screen::~Screen()
+{
+    if (io >= 0)
+        ::close(io);
+}
+
+unsigned long long Screen::write_counter() const
+{
+    if (io < 0)
+        return 0;
+
+    char text[512];
+    const ssize_t n = ::pread(io, text, sizeof(text) - 1, 0);
+    if (n <= 0)
+        return 0;
+
+    const std::string_view view(text, static_cast<size_t>(n));
+    const size_t pos = view.find("wchar:");
+    if (pos == std::string_view::npos)
+        return 0;
+
+    size_t start = pos + 6;
+    while (start < view.size() && view[start] == ' ')
+        start++;
+
+    unsigned long long value = 0;
+    std::from_chars(view.data() + start, view.data() + view.size(), value);
+    return value;
+}
+
+void Screen::invalidate()
+{
+    std::fill(stale.begin(), stale.end(), true);
+}
+
+void Screen::invalidate_rows(const unsigned int first, const unsigned int count)
+{
+    for (unsigned int row = first; row < first + count && row < y; row++)
+    {
+        stale[row] = true;
+    }
+}
+
+void Screen::overlay(const unsigned int row, const std::string_view text)
+{
+    if (overlay_pair)
+        attron(COLOR_PAIR(overlay_pair));
+
+    mvaddnstr(static_cast<int>(row), 0, text.data(), static_cast<int>(text.size()));
+
+    if (overlay_pair)
+        attroff(COLOR_PAIR(overlay_pair));
+
+    invalidate_rows(row, 1);
+}
+
+void Screen::write_run(const unsigned int row, const unsigned int col, const char *text, const unsigned int count, const uint16_t material)
+{
+    const int pair = material != NO_MATERIAL ? material + 1 : 0;
+
+    if (pair > 0)
+        attron(COLOR_PAIR(pair));
+
+    mvaddnstr(static_cast<int>(row), static_cast<int>(col), text, static_cast<int>(count));
+
+    if (pair > 0)
+        attroff(COLOR_PAIR(pair));
+}
+
+void Screen::present(const Buffer &buf)
+{
+    if (color_support)
+        present_rows<true>(buf);
+    else
+        present_rows<false>(buf);
+}
+
+template<bool color>
+void Screen::present_rows(const Buffer &buf)
+{
+    // new size, nothing on terminal is known
+    if (buf.x != x || buf.y != y)
+    {
+        x = buf.x;
+        y = buf.y;
+        glyphs.assign(static_cast<size_t>(x) * y, ' ');
+        materials.assign(static_cast<size_t>(x) * y, NO_MATERIAL);
+        stale.assign(y, true);
+    }
+
+    cells = 0;
+
+    for (unsigned int row = 0; row < y; row++)
+    {
+        const size_t offset = static_cast<size_t>(row) * x;
+        const char *next_glyphs = buf.glyphs.data() + offset;
+        const uint16_t *next_materials = buf.materials.data() + offset;
+        char *prev_glyphs = glyphs.data() + offset;
+        uint16_t *prev_materials = materials.data() + offset;
+
+        const bool whole = stale[row];
+        stale[row] = false;
+
+        // unchanged row costs compare of planes
+        if (!whole && std::memcmp(next_glyphs, prev_glyphs, x) == 0 && (!color || std::memcmp(next_materials, prev_materials, x * sizeof(uint16_t)) == 0))
+            continue;
+
+        auto changed = [&](const unsigned int c) {
+            if constexpr (color)
+                return whole || next_glyphs[c] != prev_glyphs[c] || next_materials[c] != prev_materials[c];
+            else
+                return whole || next_glyphs[c] != prev_glyphs[c];
+        };
+
+        unsigned int col = 0;
+        while (col < x)
+        {
+            // skip unchanged cells
+            if (!changed(col))
+            {
+                col++;
+                continue;
+            }
+
+            // run of changed cells with one material
+            const unsigned int start = col;
+            const uint16_t material = color ? next_materials[col] : NO_MATERIAL;
+
+            while (col < x && (!color || next_materials[col] == material) && changed(col))
+            {
+                col++;
+            }
+
+            write_run(row, start, next_glyphs + start, col - start, material);
+            cells += col - start;
+        }
+
+        std::memcpy(prev_glyphs, next_glyphs, x);
+        if constexpr (color)
+            std::memcpy(prev_materials, next_materials, x * sizeof(uint16_t));
+    }
+}
+
+void Screen::flush()
+{
+    refresh();
+
+    const unsigned long long counter = write_counter();
+    bytes = static_cast<unsigned long>(counter - std::min(counter, written));
+    written = counter;
+}
@@ -0,0 +1,57 @@
+/*
+ * screen.h
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <ncurses.h>
+
+#include "buffer.h"
+#include "presenter.h"
+
+// ncurses presenter, writes only cells changed since previous frame
+// created and flushed on thread that runs curses, bytes are those written by it
+class Screen : public Presenter {
+public:
+    int overlay_pair = 0;       // color pair of overlay text, 0 - default colors
+
+    // without color support material plane is ignored, cells differ by glyph only
+    explicit Screen(bool color_support = true);
+    ~Screen() override;
+
+    Screen(const Screen &) = delete;
+    Screen &operator=(const Screen &) = delete;
+
+    // writes changed runs of buffer into curses window
+    void present(const Buffer &buf) override;
+
+    void overlay(unsigned int row, std::string_view text) override;
+
+    // refresh, counts bytes written to terminal
+    void flush() override;
+
+    void invalidate() override;
+
+    // rows overwritten outside of present, rewritten on next present
+    void invalidate_rows(unsigned int first, unsigned int count);
+
+private:
+    bool color_support;
+    unsigned int x = 0, y = 0;
+    std::vector<char> glyphs;           // previous frame
+    std::vector<uint16_t> materials;
+    std::vector<bool> stale;            // rows that must be rewritten
+
+    int io = -1;                        // /proc/thread-self/io, write counter of presenting thread
+    unsigned long long written = 0;     // counter at previous flush
+
+    [[nodiscard]] unsigned long long write_counter() const;
+
+    // diff of frame, one instance per color mode
+    template<bool color>
+    void present_rows(const Buffer &buf);
+
+    static void write_run(unsigned int row, unsigned int col, const char *text, unsigned int count, uint16_t material);
+};
@@ -0,0 +1,241 @@
+/*
+ * transform.cpp
+ */
+
+#include "transform.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Bounds methods
+
+void Bounds::merge(const Bounds &other)
+{
+    min_x = std::min(min_x, other.min_x);
+    max_x = std::max(max_x, other.max_x);
+    min_y = std::min(min_y, other.min_y);
+    max_y = std::max(max_y, other.max_y);
+}
+
+// ProjectedVertices methods
+
+void ProjectedVertices::resize(const size_t count)
+{
+    rx.resize(count);
+    ry.resize(count);
+    rz.resize(count);
+    sx.resize(count);
+    sy.resize(count);
+    sz.resize(count);
+}
+
+// kernels
+
+Bounds transform_project(const float *x, const float *y, const float *z, const size_t count, const ViewTransform &view,
+                         float *rx, float *ry, float *rz, float *sx, float *sy, float *sz)
+{
+    const auto &m = view.rotation.m;
+
+    // projection as in Vec3::to_screen, halving is exact so factoring it out keeps results bit identical
+    const float half_zoom = 0.5f * view.zoom;
+    const float center_x = 0.5f * view.logical_x;
+    const float center_y = 0.5f * view.logical_y;
+
+    Bounds bounds;
+    size_t i = 0;
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(__ARM_NEON)
+    float lanes_min_x[8], lanes_max_x[8], lanes_min_y[8], lanes_max_y[8];
+    size_t lanes = 0;
+#endif
+
+#if defined(__AVX__)
+    lanes = 8;
+    {
+        const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+        const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+        const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+        const __m256 hz = _mm256_set1_ps(half_zoom);
+        const __m256 cx = _mm256_set1_ps(center_x);
+        const __m256 cy = _mm256_set1_ps(center_y);
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        __m256 vmin_x = _mm256_set1_ps(bounds.min_x), vmax_x = _mm256_set1_ps(bounds.max_x);
+        __m256 vmin_y = _mm256_set1_ps(bounds.min_y), vmax_y = _mm256_set1_ps(bounds.max_y);
+
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 vx = _mm256_loadu_ps(x + i);
+            const __m256 vy = _mm256_loadu_ps(y + i);
+            const __m256 vz = _mm256_loadu_ps(z + i);
+
+            const __m256 r_x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, vx), _mm256_mul_ps(m01, vy)), _mm256_mul_ps(m02, vz));
+            const __m256 r_y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, vx), _mm256_mul_ps(m11, vy)), _mm256_mul_ps(m12, vz));
+            const __m256 r_z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m20, vx), _mm256_mul_ps(m21, vy)), _mm256_mul_ps(m22, vz));
+
+            const __m256 s_x = _mm256_add_ps(cx, _mm256_mul_ps(r_x, hz));
+            const __m256 s_y = _mm256_sub_ps(cy, _mm256_mul_ps(r_y, hz));
+            const __m256 s_z = _mm256_add_ps(_mm256_mul_ps(r_z, hz), half);
+
+            _mm256_storeu_ps(rx + i, r_x);
+            _mm256_storeu_ps(ry + i, r_y);
+            _mm256_storeu_ps(rz + i, r_z);
+            _mm256_storeu_ps(sx + i, s_x);
+            _mm256_storeu_ps(sy + i, s_y);
+            _mm256_storeu_ps(sz + i, s_z);
+
+            vmin_x = _mm256_min_ps(vmin_x, s_x);
+            vmax_x = _mm256_max_ps(vmax_x, s_x);
+            vmin_y = _mm256_min_ps(vmin_y, s_y);
+            vmax_y = _mm256_max_ps(vmax_y, s_y);
+        }
+
+        _mm256_storeu_ps(lanes_min_x, vmin_x);
+        _mm256_storeu_ps(lanes_max_x, vmax_x);
+        _mm256_storeu_ps(lanes_min_y, vmin_y);
+        _mm256_storeu_ps(lanes_max_y, vmax_y);
+    }
+#elif defined(__SSE2__)
+    lanes = 4;
+    {
+        const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+        const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+        const __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]);
+        const __m128 hz = _mm_set1_ps(half_zoom);
+        const __m128 cx = _mm_set1_ps(center_x);
+        const __m128 cy = _mm_set1_ps(center_y);
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        __m128 vmin_x = _mm_set1_ps(bounds.min_x), vmax_x = _mm_set1_ps(bounds.max_x);
+        __m128 vmin_y = _mm_set1_ps(bounds.min_y), vmax_y = _mm_set1_ps(bounds.max_y);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 vx = _mm_loadu_ps(x + i);
+            const __m128 vy = _mm_loadu_ps(y + i);
+            const __m128 vz = _mm_loadu_ps(z + i);
+
+            const __m128 r_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, vx), _mm_mul_ps(m01, vy)), _mm_mul_ps(m02, vz));
+            const __m128 r_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, vx), _mm_mul_ps(m11, vy)), _mm_mul_ps(m12, vz));
+            const __m128 r_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, vx), _mm_mul_ps(m21, vy)), _mm_mul_ps(m22, vz));
+
+            const __m128 s_x = _mm_add_ps(cx, _mm_mul_ps(r_x, hz));
+            const __m128 s_y = _mm_sub_ps(cy, _mm_mul_ps(r_y, hz));
+            const __m128 s_z = _mm_add_ps(_mm_mul_ps(r_z, hz), half);
+
+            _mm_storeu_ps(rx + i, r_x);
+            _mm_storeu_ps(ry + i, r_y);
+            _mm_storeu_ps(rz + i, r_z);
+            _mm_storeu_ps(sx + i, s_x);
+            _mm_storeu_ps(sy + i, s_y);
+            _mm_storeu_ps(sz + i, s_z);
+
+            vmin_x = _mm_min_ps(vmin_x, s_x);
+            vmax_x = _mm_max_ps(vmax_x, s_x);
+            vmin_y = _mm_min_ps(vmin_y, s_y);
+            vmax_y = _mm_max_ps(vmax_y, s_y);
+        }
+
+        _mm_storeu_ps(lanes_min_x, vmin_x);
+        _mm_storeu_ps(lanes_max_x, vmax_x);
+        _mm_storeu_ps(lanes_min_y, vmin_y);
+        _mm_storeu_ps(lanes_max_y, vmax_y);
+    }
+#elif defined(__ARM_NEON)
+    lanes = 4;
+    {
+        const float32x4_t hz = vdupq_n_f32(half_zoom);
+        const float32x4_t cx = vdupq_n_f32(center_x);
+        const float32x4_t cy = vdupq_n_f32(center_y);
+        const float32x4_t half = vdupq_n_f32(0.5f);
+
+        float32x4_t vmin_x = vdupq_n_f32(bounds.min_x), vmax_x = vdupq_n_f32(bounds.max_x);
+        float32x4_t vmin_y = vdupq_n_f32(bounds.min_y), vmax_y = vdupq_n_f32(bounds.max_y);
+
+        // separate multiply and add, fused variants would round differently from scalar tail
+        for (; i + 4 <= count; i += 4)
+        {
+            const float32x4_t vx = vld1q_f32(x + i);
+            const float32x4_t vy = vld1q_f32(y + i);
+            const float32x4_t vz = vld1q_f32(z + i);
+
+            const float32x4_t r_x = vaddq_f32(vaddq_f32(vmulq_n_f32(vx, m[0][0]), vmulq_n_f32(vy, m[0][1])), vmulq_n_f32(vz, m[0][2]));
+            const float32x4_t r_y = vaddq_f32(vaddq_f32(vmulq_n_f32(vx, m[1][0]), vmulq_n_f32(vy, m[1][1])), vmulq_n_f32(vz, m[1][2]));
+            const float32x4_t r_z = vaddq_f32(vaddq_f32(vmulq_n_f32(vx, m[2][0]), vmulq_n_f32(vy, m[2][1])), vmulq_n_f32(vz, m[2][2]));
+
+            const float32x4_t s_x = vaddq_f32(cx, vmulq_f32(r_x, hz));
+            const float32x4_t s_y = vsubq_f32(cy, vmulq_f32(r_y, hz));
+            const float32x4_t s_z = vaddq_f32(vmulq_f32(r_z, hz), half);
+
+            vst1q_f32(rx + i, r_x);
+            vst1q_f32(ry + i, r_y);
+            vst1q_f32(rz + i, r_z);
+            vst1q_f32(sx + i, s_x);
+            vst1q_f32(sy + i, s_y);
+            vst1q_f32(sz + i, s_z);
+
+            vmin_x = vminq_f32(vmin_x, s_x);
+            vmax_x = vmaxq_f32(vmax_x, s_x);
+            vmin_y = vminq_f32(vmin_y, s_y);
+            vmax_y = vmaxq_f32(vmax_y, s_y);
+        }
+
+        vst1q_f32(lanes_min_x, vmin_x);
+        vst1q_f32(lanes_max_x, vmax_x);
+        vst1q_f32(lanes_min_y, vmin_y);
+        vst1q_f32(lanes_max_y, vmax_y);
+    }
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(__ARM_NEON)
+    for (size_t l = 0; l < lanes; l++)
+    {
+        bounds.min_x = std::min(bounds.min_x, lanes_min_x[l]);
+        bounds.max_x = std::max(bounds.max_x, lanes_max_x[l]);
+        bounds.min_y = std::min(bounds.min_y, lanes_min_y[l]);
+        bounds.max_y = std::max(bounds.max_y, lanes_max_y[l]);
+    }
+#endif
+
+    // scalar fallback and tail
+    for (; i < count; i++)
+    {
+        const float r_x = m[0][0] * x[i] + m[0][1] * y[i] + m[0][2] * z[i];
+        const float r_y = m[1][0] * x[i] + m[1][1] * y[i] + m[1][2] * z[i];
+        const float r_z = m[2][0] * x[i] + m[2][1] * y[i] + m[2][2] * z[i];
+
+        const float s_x = center_x + r_x * half_zoom;
+        const float s_y = center_y - r_y * half_zoom;
+        const float s_z = r_z * half_zoom + 0.5f;
+
+        rx[i] = r_x;
+        ry[i] = r_y;
+        rz[i] = r_z;
+        sx[i] = s_x;
+        sy[i] = s_y;
+        sz[i] = s_z;
+
+        bounds.min_x = std::min(bounds.min_x, s_x);
+        bounds.max_x = std::max(bounds.max_x, s_x);
+        bounds.min_y = std::min(bounds.min_y, s_y);
+        bounds.max_y = std::max(bounds.max_y, s_y);
+    }
+
+    return bounds;
+}
+
+Bounds transform_project(const Mesh &mesh, const ViewTransform &view, ProjectedVertices &out)
+{
+    const size_t count = mesh.vertex_count();
+    out.resize(count);
+
+    return transform_project(mesh.x.data(), mesh.y.data(), mesh.z.data(), count, view,
+                             out.rx.data(), out.ry.data(), out.rz.data(), out.sx.data(), out.sy.data(), out.sz.data());
+}
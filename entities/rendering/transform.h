@@ -0,0 +1,55 @@
+/*
+ * transform.h
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "entities/geometry/object.h"
+#include "entities/view/camera.h"
+#include "utils/mathematics.h"
+#include "utils/memory.h"
+
+// transformation of one frame - camera rotation and orthographic projection into logical buffer
+class ViewTransform {
+public:
+    Mat3 rotation;              // object to camera space
+    float zoom;
+    float logical_x, logical_y; // logical buffer size
+
+    ViewTransform(const Camera &cam, float logical_x, float logical_y) : rotation(cam.view()), zoom(cam.zoom), logical_x(logical_x), logical_y(logical_y) {}
+
+    [[nodiscard]] Vec3 rotate(const Vec3 &v) const { return rotation * v; }
+    [[nodiscard]] Vec3 project(const Vec3 &rotated) const { return Vec3::to_screen(rotated, zoom, logical_x, logical_y); }
+};
+
+// screen space bounds of projected vertices
+class Bounds {
+public:
+    float min_x = std::numeric_limits<float>::max();
+    float max_x = -std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_y = -std::numeric_limits<float>::max();
+
+    void merge(const Bounds &other);
+};
+
+// transformed vertices in structure of arrays layout
+class ProjectedVertices {
+public:
+    AlignedVector<float> rx, ry, rz;    // camera space
+    AlignedVector<float> sx, sy, sz;    // screen space without centering offset
+
+    void resize(size_t count);  // keeps storage when shrinking, new elements are uninitialized
+};
+
+// batch kernel - rotates and projects count vertices in one pass, returns screen bounds of them
+// uses widest available simd (avx, sse2 or neon) with scalar tail, every path rounds identically
+Bounds transform_project(const float *x, const float *y, const float *z, size_t count, const ViewTransform &view,
+                         float *rx, float *ry, float *rz, float *sx, float *sy, float *sz);
+
+// same over whole mesh
+Bounds transform_project(const Mesh &mesh, const ViewTransform &view, ProjectedVertices &out);
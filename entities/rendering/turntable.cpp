@@ -0,0 +1,253 @@
+/*
+ * turntable.cpp
+ */
+
+#include "turntable.h"
+
+#include <cmath>
+#include <numeric>
+
+// EncodedFrame methods
+
+void EncodedFrame::encode(const Buffer &buf)
+{
+    runs.clear();
+
+    const size_t cells = static_cast<size_t>(buf.x) * buf.y;
+    for (size_t i = 0; i < cells; i++)
+    {
+        const char glyph = buf.glyphs[i];
+        const uint16_t material = buf.materials[i];
+
+        if (!runs.empty() && runs.back().glyph == glyph && runs.back().material == material && runs.back().count < UINT16_MAX)
+        {
+            runs.back().count++;
+            continue;
+        }
+
+        runs.push_back({1, material, glyph});
+    }
+}
+
+void EncodedFrame::decode(Buffer &buf) const
+{
+    size_t i = 0;
+    for (const auto &run : runs)
+    {
+        std::fill_n(buf.glyphs.begin() + static_cast<std::ptrdiff_t>(i), run.count, run.glyph);
+        std::fill_n(buf.materials.begin() + static_cast<std::ptrdiff_t>(i), run.count, run.material);
+        i += run.count;
+    }
+}
+
+// Turntable methods
+
+Turntable Turntable::of(const bool animate_azimuth, const float speed_azimuth, const bool animate_altitude, const float speed_altitude)
+{
+    Turntable turn;
+
+    // frames of one turn of axis, 0 if axis stands still
+    auto frames_of = [](const bool animated, const float speed) -> size_t {
+        const float step = std::abs(speed) * FRAME_DURATION;
+        return animated && step > 0.0f ? std::max<size_t>(1, static_cast<size_t>(std::lround(360.0f / step))) : 0;
+    };
+
+    const size_t azimuth_frames = frames_of(animate_azimuth, speed_azimuth);
+    const size_t altitude_frames = frames_of(animate_altitude, speed_altitude);
+
+    if (azimuth_frames == 0 && altitude_frames == 0)
+    {
+        return turn;
+    }
+
+    // both axes back at start after common multiple of their turns
+    const size_t frames = azimuth_frames == 0 ? altitude_frames
+                        : altitude_frames == 0 ? azimuth_frames
+                        : std::lcm(azimuth_frames, altitude_frames);
+
+    if (frames > TURNTABLE_MAX_FRAMES)
+    {
+        return turn;
+    }
+
+    turn.frames = frames;
+    turn.step_azimuth = azimuth_frames ? std::copysign(360.0f / static_cast<float>(azimuth_frames), speed_azimuth) : 0.0f;
+    turn.step_altitude = altitude_frames ? std::copysign(360.0f / static_cast<float>(altitude_frames), speed_altitude) : 0.0f;
+    return turn;
+}
+
+Camera Turntable::view(const Camera &start, const size_t index) const
+{
+    // angle from index, not accumulated steps, so frame k is same view on every turn
+    Camera cam = start;
+    cam.rotate_left(std::fmod(step_azimuth * static_cast<float>(index), 360.0f));
+    cam.rotate_down(std::fmod(step_altitude * static_cast<float>(index), 360.0f));
+    return cam;
+}
+
+// FrameCache methods
+
+FrameCache::FrameCache(const Light &light, const bool static_light, const bool color_support, const bool front_to_back, const size_t budget)
+    : light(light), static_light(static_light), color_support(color_support), front_to_back(front_to_back), budget(budget) {}
+
+FrameCache::~FrameCache()
+{
+    stop();
+}
+
+void FrameCache::stop()
+{
+    stopping.store(true);
+    if (worker.joinable())
+        worker.join();
+    stopping.store(false);
+}
+
+void FrameCache::reset(std::shared_ptr<const Object> model, const Turntable &next, const Camera &view, const unsigned int width, const unsigned int height, const float lx, const float ly)
+{
+    stop();
+
+    obj = std::move(model);
+    turn = next;
+    start = view;
+    x = width;
+    y = height;
+    logical_x = lx;
+    logical_y = ly;
+
+    {
+        std::lock_guard lock(mutex);
+        entries.clear();
+        entries.resize(turn.frames);
+        total = count = 0;
+    }
+
+    if (obj && turn.frames > 0)
+        worker = std::thread(&FrameCache::run, this);
+}
+
+void FrameCache::clear()
+{
+    stop();
+
+    std::lock_guard lock(mutex);
+    entries.clear();
+    total = count = 0;
+    obj.reset();
+}
+
+bool FrameCache::fetch(const size_t index, Buffer &buf)
+{
+    std::lock_guard lock(mutex);
+    if (index >= entries.size() || !entries[index].valid)
+        return false;
+
+    if (buf.x != x || buf.y != y || buf.logical_x != logical_x || buf.logical_y != logical_y)
+        buf = Buffer(x, y, logical_x, logical_y);
+
+    entries[index].used = ++tick;
+    entries[index].frame.decode(buf);
+    return true;
+}
+
+void FrameCache::store(const size_t index, const Buffer &buf)
+{
+    if (buf.x != x || buf.y != y)
+        return;
+
+    EncodedFrame encoded;
+    encoded.encode(buf);
+    encoded.runs.shrink_to_fit();
+
+    std::lock_guard lock(mutex);
+    if (index >= entries.size() || encoded.bytes() > budget)
+        return;
+
+    Entry &entry = entries[index];
+    entry.used = ++tick;
+
+    if (entry.valid)
+        return;
+
+    evict(encoded.bytes());
+
+    entry.frame = std::move(encoded);
+    entry.valid = true;
+    total += entry.frame.bytes();
+    count++;
+}
+
+size_t FrameCache::cached() const
+{
+    std::lock_guard lock(mutex);
+    return count;
+}
+
+size_t FrameCache::bytes() const
+{
+    std::lock_guard lock(mutex);
+    return total;
+}
+
+void FrameCache::evict(const size_t needed)
+{
+    while (count > 0 && total + needed > budget)
+    {
+        size_t oldest = entries.size();
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (entries[i].valid && (oldest == entries.size() || entries[i].used < entries[oldest].used))
+                oldest = i;
+        }
+
+        Entry &entry = entries[oldest];
+        total -= entry.frame.bytes();
+        count--;
+        entry.valid = false;
+        std::vector<EncodedFrame::Run>().swap(entry.frame.runs);
+    }
+}
+
+void FrameCache::run()
+{
+    // one core in background, interactive frames keep render pool for themselves
+    Renderer renderer(front_to_back);
+    renderer.reserve(*obj);
+
+    Buffer buf(x, y, logical_x, logical_y);
+    EncodedFrame encoded;
+
+    for (size_t k = 0; k < turn.frames && !stopping.load(); k++)
+    {
+        {
+            std::lock_guard lock(mutex);
+            if (entries[k].valid)
+                continue;
+        }
+
+        buf.clear();
+        renderer.render(buf, *obj, turn.view(start, k), light, static_light, color_support);
+        encoded.encode(buf);
+
+        // exact copy, budget and totals both count capacity
+        EncodedFrame stored;
+        stored.runs.assign(encoded.runs.begin(), encoded.runs.end());
+        stored.runs.shrink_to_fit();
+
+        std::lock_guard lock(mutex);
+
+        // ahead rendering never evicts, frames beyond budget are rendered when shown
+        if (total + stored.bytes() > budget)
+            return;
+
+        Entry &entry = entries[k];
+        if (entry.valid)
+            continue;
+
+        entry.frame = std::move(stored);
+        entry.valid = true;
+        entry.used = ++tick;
+        total += entry.frame.bytes();
+        count++;
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * turntable.h
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer.h"
+#include "renderer.h"
+#include "entities/geometry/object.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+#include "config.h"
+
+// frame as runs of equal cells, depth is not kept
+class EncodedFrame {
+public:
+    class Run {
+    public:
+        uint16_t count;
+        uint16_t material;
+        char glyph;
+    };
+
+    std::vector<Run> runs;
+
+    void encode(const Buffer &buf);
+    void decode(Buffer &buf) const;     // buffer must have size of encoded one
+
+    [[nodiscard]] size_t bytes() const { return runs.capacity() * sizeof(Run); }
+};
+
+// one revolution of animation in fixed steps, frame k shows start view turned k steps
+class Turntable {
+public:
+    size_t frames = 0;                  // frames per revolution, 0 if animation does not repeat soon enough
+    float step_azimuth = 0.0f;          // degrees per frame
+    float step_altitude = 0.0f;
+
+    // steps are rounded so that every animated axis closes its turn after whole number of frames
+    static Turntable of(bool animate_azimuth, float speed_azimuth, bool animate_altitude, float speed_altitude);
+
+    [[nodiscard]] Camera view(const Camera &start, size_t index) const;
+};
+
+// frames of turntable rendered ahead by own thread, least recently shown frames are evicted above byte budget
+class FrameCache {
+public:
+    FrameCache(const Light &light, bool static_light, bool color_support, bool front_to_back, size_t budget);
+    ~FrameCache();
+
+    FrameCache(const FrameCache &) = delete;
+    FrameCache &operator=(const FrameCache &) = delete;
+
+    // drops frames and starts rendering ahead for model, turn starting at camera and buffer size
+    void reset(std::shared_ptr<const Object> obj, const Turntable &turn, const Camera &start, unsigned int x, unsigned int y, float logical_x, float logical_y);
+
+    // stops rendering ahead and drops frames
+    void clear();
+
+    // decodes frame into buffer resized as needed, false if frame is not cached
+    bool fetch(size_t index, Buffer &buf);
+
+    // keeps frame rendered elsewhere, evicts least recently used ones over budget
+    void store(size_t index, const Buffer &buf);
+
+    // cached frames and their bytes
+    [[nodiscard]] size_t cached() const;
+    [[nodiscard]] size_t bytes() const;
+
+private:
+    class Entry {
+    public:
+        EncodedFrame frame;
+        bool valid = false;
+        unsigned long used = 0;         // tick of last fetch or store
+    };
+
+    const Light &light;
+    const bool static_light, color_support, front_to_back;
+    const size_t budget;
+
+    // settings of current turn, written only while worker is stopped
+    std::shared_ptr<const Object> obj;
+    Turntable turn;
+    Camera start;
+    unsigned int x = 0, y = 0;
+    float logical_x = 0.0f, logical_y = 0.0f;
+
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;         // guarded by mutex, one per frame of turn
+    size_t total = 0;                   // bytes of valid entries
+    size_t count = 0;                   // valid entries
+    unsigned long tick = 0;
+
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+
+    void stop();
+    void run();
+    void evict(size_t needed);          // caller holds mutex
+};
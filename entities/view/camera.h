@@ -41,6 +41,12 @@ public:
         altitude = rad_norm(altitude  - deg2rad(degree));
     }
 
+    // world to camera rotation, composed once per frame
+    [[nodiscard]] Mat3 view() const
+    {
+        return Mat3::rotation_x(-altitude) * Mat3::rotation_y(-azimuth);
+    }
+
     void zoom_in(float step = ZOOM_STEP)
     {
         zoom = std::min(zoom + step, ZOOM_MAX);
@@ -3,20 +3,43 @@
  */
 
 #include <ncurses.h>
+#include <sys/select.h>
+#include <csignal>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <chrono>
-#include <thread>
 
 #include "entities/geometry/object.h"
+#include "entities/geometry/cache.h"
+#include "entities/geometry/loader.h"
+#include "entities/geometry/materials.h"
+#include "entities/geometry/stream.h"
+#include "entities/rendering/ansi.h"
+#include "entities/rendering/batch.h"
+#include "entities/rendering/benchmark.h"
 #include "entities/rendering/buffer.h"
+#include "entities/rendering/export.h"
+#include "entities/rendering/pipeline.h"
+#include "entities/rendering/profiler.h"
 #include "entities/rendering/renderer.h"
+#include "entities/rendering/screen.h"
+#include "entities/rendering/turntable.h"
+#include "utils/deferred_log.h"
+#include "utils/frame_scheduler.h"
+#include "utils/scoped_timer.h"
+#include "utils/thread_pool.h"
 #include "utils/tools.h"
 #include "config.h"
 #include "version.h"
@@ -46,7 +69,43 @@ void init_ncurses()
     noecho();               // disable echoing of typed characters
     curs_set(0);            // hide the cursor
     keypad(stdscr, true);   // enable special keys (arrows, etc.)
-    timeout(1);             // make getch() non-blocking
+    nodelay(stdscr, true);  // make getch() non-blocking, waiting is done by wait_events
+}
+
+// blocks SIGWINCH so that only wait_events receives it, old mask is returned for waiting
+// must run before any thread starts, threads inherit the blocked mask
+sigset_t block_resize_signal()
+{
+    sigset_t resize;
+    sigemptyset(&resize);
+    sigaddset(&resize, SIGWINCH);
+
+    sigset_t previous;
+    sigprocmask(SIG_BLOCK, &resize, &previous);
+    return previous;
+}
+
+// sleeps until key on stdin, readable notifier, terminal resize or timeout in seconds, negative timeout waits for event only
+// resize signal is delivered atomically with waiting, ncurses handler then reports KEY_RESIZE from getch
+void wait_events(const float timeout, const sigset_t &wait_mask, const int notifier = -1, const int second = -1)
+{
+    fd_set input;
+    FD_ZERO(&input);
+    FD_SET(STDIN_FILENO, &input);
+    if (notifier >= 0)
+        FD_SET(notifier, &input);
+    if (second >= 0)
+        FD_SET(second, &input);
+
+    timespec limit{};
+    if (timeout >= 0.0f)
+    {
+        const auto ns = static_cast<long long>(timeout * 1e9f);
+        limit.tv_sec = static_cast<time_t>(ns / 1000000000);
+        limit.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+
+    pselect(std::max({STDIN_FILENO, notifier, second}) + 1, &input, nullptr, nullptr, timeout >= 0.0f ? &limit : nullptr, &wait_mask);
 }
 
 void init_colors(const std::vector<Material> &materials, Theme theme)
@@ -109,7 +168,7 @@ void init_colors(const std::vector<Material> &materials, Theme theme)
 static void print_help()
 {
     std::cout <<
-        "Usage: " << APP_NAME << " [OPTIONS] <file.obj>\n"
+        "Usage: " << APP_NAME << " [OPTIONS] <file.obj>...\n"
         "\n"
         "Options:\n"
         "  -c, --color <theme>  Enable colors support, optional theme {dark|light|transparent}\n"
@@ -123,6 +182,20 @@ static void print_help()
         "      --invert-x       Flip geometry along X axis\n"
         "      --invert-y       Flip geometry along Y axis\n"
         "      --invert-z       Flip geometry along Z axis\n"
+        "      --cache          Reuse parsed model from .objc sidecar, write it if missing\n"
+        "      --no-lod         Always draw full mesh instead of simplified levels\n"
+        "      --no-sort        Draw faces in file order instead of nearest clusters first\n"
+        "      --ansi           Write frames as raw truecolor ANSI instead of through ncurses\n"
+        "      --frame-cache <MB>  Play -az/-al loop from cache of one pre-rendered turn, at most MB\n"
+        "      --stream <MB>    Page model in from clustered .objs sidecar, at most MB resident, write it if missing\n"
+        "  -t, --threads <n>    Threads for loading and drawing, models at once in batch [default: all cores]\n"
+        "      --bench <n>      Render n frames of orbit without terminal and print stage timings\n"
+        "      --size <WxH>     Buffer size of benchmark and export [default: " << BENCH_WIDTH << "x" << BENCH_HEIGHT << "]\n"
+        "      --json           Print benchmark report as JSON\n"
+        "      --export <n>     Render n frames of animation without terminal and stream them\n"
+        "      --format <fmt>   Format of exported frames {ansi|asciicast} [default: ansi]\n"
+        "  -o, --output <path>  Write exported frames to file instead of stdout, directory in batch\n"
+        "      --profile <path> Write per-frame stage timings and counters as CSV on exit\n"
         "  -h, --help           Print help\n"
         "  -v, --version        Print version\n"
         "\n"
@@ -133,7 +206,7 @@ static void print_help()
         "  ↓, j, s              Rotate down\n"
         "  +, i                 Zoom in\n"
         "  -, o                 Zoom out\n"
-        "  Tab                  Toggle HUD\n"
+        "  Tab                  Cycle HUD pages: view, stages, work, output, off\n"
         "  q                    Quit\n";
 }
 
@@ -143,7 +216,7 @@ static void print_version()
 }
 
 struct Args {
-    std::filesystem::path input_file;
+    std::vector<std::filesystem::path> input_files; // models or directories of them
 
     bool color_support = false;             // -c / --color
     Theme theme = Theme::Dark;
@@ -153,6 +226,23 @@ struct Args {
     bool invert_x = false;                  // -x / --invert-x
     bool invert_y = false;                  // -y / --invert-y
     bool invert_z = false;                  // -z / --invert-z
+    bool use_cache = false;                 // --cache
+    bool use_lod = true;                    // --no-lod
+    bool front_to_back = true;              // --no-sort
+    bool ansi = false;                      // --ansi
+    size_t frame_cache = 0;                 // --frame-cache, megabytes, 0 - off
+    size_t stream_budget = 0;               // --stream, megabytes of resident clusters, 0 - whole model in memory
+    unsigned threads = 0;                   // -t / --threads, 0 - all cores
+
+    unsigned int bench_frames = 0;          // --bench, 0 - interactive
+    unsigned int bench_width = BENCH_WIDTH; // --size
+    unsigned int bench_height = BENCH_HEIGHT;
+    bool bench_json = false;                // --json
+
+    unsigned int export_frames = 0;         // --export, 0 - interactive
+    ExportFormat export_format = ExportFormat::Ansi;    // --format
+    std::filesystem::path export_file;      // -o / --output, empty - stdout
+    std::filesystem::path profile_file;     // --profile, empty - no dump
 
     bool animate_altitude = false;          // -al
     bool animate_azimuth = false;           // -az
@@ -312,14 +402,185 @@ static Args parse_args(int argc, char **argv)
         {
             a.invert_z = true;
         }
-        else if (arg[0] != '-')
+        else if (arg == "--cache")
+        {
+            a.use_cache = true;
+        }
+        else if (arg == "--no-lod")
+        {
+            a.use_lod = false;
+        }
+        else if (arg == "--no-sort")
+        {
+            a.front_to_back = false;
+        }
+        else if (arg == "--ansi")
+        {
+            a.ansi = true;
+        }
+        else if (arg == "--frame-cache")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: frame cache needs value\n";
+                std::exit(1);
+            }
+
+            auto val = safe_stoi(argv[i]);
+
+            if (!val || val.value() < 1)
+            {
+                std::cerr << "error: invalid frame cache value\n";
+                std::exit(1);
+            }
+
+            a.frame_cache = static_cast<size_t>(val.value());
+        }
+        else if (arg == "--stream")
         {
-            if (!a.input_file.empty())
+            if (++i == argc)
             {
-                std::cerr << "error: more arguments than expected\n";
+                std::cerr << "error: stream needs value\n";
                 std::exit(1);
             }
-            a.input_file = arg;
+
+            auto val = safe_stoi(argv[i]);
+
+            if (!val || val.value() < 1)
+            {
+                std::cerr << "error: invalid stream value\n";
+                std::exit(1);
+            }
+
+            a.stream_budget = static_cast<size_t>(val.value());
+        }
+        else if (arg == "-t" || arg == "--threads")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: threads needs value\n";
+                std::exit(1);
+            }
+
+            auto val = safe_stoi(argv[i]);
+
+            if (!val || val.value() < 1)
+            {
+                std::cerr << "error: invalid threads value\n";
+                std::exit(1);
+            }
+
+            a.threads = static_cast<unsigned>(val.value());
+        }
+        else if (arg == "--bench")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: bench needs value\n";
+                std::exit(1);
+            }
+
+            auto val = safe_stoi(argv[i]);
+
+            if (!val || val.value() < 1)
+            {
+                std::cerr << "error: invalid bench value\n";
+                std::exit(1);
+            }
+
+            a.bench_frames = static_cast<unsigned int>(val.value());
+        }
+        else if (arg == "--size")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: size needs value\n";
+                std::exit(1);
+            }
+
+            const std::string_view size{argv[i]};
+            const size_t sep = size.find('x');
+            auto w = sep == std::string_view::npos ? std::nullopt : parse_int(size.substr(0, sep));
+            auto h = sep == std::string_view::npos ? std::nullopt : parse_int(size.substr(sep + 1));
+
+            if (!w || !h || w.value() < 1 || h.value() < 1)
+            {
+                std::cerr << "error: invalid size value\n";
+                std::exit(1);
+            }
+
+            a.bench_width = static_cast<unsigned int>(w.value());
+            a.bench_height = static_cast<unsigned int>(h.value());
+        }
+        else if (arg == "--json")
+        {
+            a.bench_json = true;
+        }
+        else if (arg == "--export")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: export needs value\n";
+                std::exit(1);
+            }
+
+            auto val = safe_stoi(argv[i]);
+
+            if (!val || val.value() < 1)
+            {
+                std::cerr << "error: invalid export value\n";
+                std::exit(1);
+            }
+
+            a.export_frames = static_cast<unsigned int>(val.value());
+        }
+        else if (arg == "--format")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: format needs value\n";
+                std::exit(1);
+            }
+
+            const std::string_view format{argv[i]};
+
+            if (format == "ansi")
+            {
+                a.export_format = ExportFormat::Ansi;
+            }
+            else if (format == "asciicast")
+            {
+                a.export_format = ExportFormat::Asciicast;
+            }
+            else
+            {
+                std::cerr << "error: invalid format value\n";
+                std::exit(1);
+            }
+        }
+        else if (arg == "-o" || arg == "--output")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: output needs value\n";
+                std::exit(1);
+            }
+
+            a.export_file = argv[i];
+        }
+        else if (arg == "--profile")
+        {
+            if (++i == argc)
+            {
+                std::cerr << "error: profile needs value\n";
+                std::exit(1);
+            }
+
+            a.profile_file = argv[i];
+        }
+        else if (arg[0] != '-')
+        {
+            a.input_files.emplace_back(arg);
         }
 
         // unknown
@@ -331,7 +592,7 @@ static Args parse_args(int argc, char **argv)
         }
     }
 
-    if (a.input_file.empty())
+    if (a.input_files.empty())
     {
         std::cerr << "error: no input file\n";
         std::cerr << "type '--help' for usage\n";
@@ -343,18 +604,236 @@ static Args parse_args(int argc, char **argv)
 
 // helpers
 
-void render_hud(const Camera &cam, const float fps)
+// pages of hud cycled by tab
+enum class HudPage { Off, View, Stages, Work, Output, Count };
+
+static HudPage next_page(const HudPage page)
+{
+    return static_cast<HudPage>((static_cast<int>(page) + 1) % static_cast<int>(HudPage::Count));
+}
+
+// measured pages, averages of newest frames
+static void render_profile(const HudPage page, const FrameProfile &mean, const float fps, Presenter &presenter)
+{
+    char line[64];
+    unsigned int row = 0;
+
+    const auto print = [&](const char *format, const auto value) {
+        std::snprintf(line, sizeof(line), format, value);
+        presenter.overlay(row++, line);
+    };
+
+    switch (page)
+    {
+        case HudPage::Stages:
+            print("render    %8.2f ms", mean.render);
+            print("clear     %8.2f ms", mean.clear);
+            print("transform %8.2f ms", mean.transform);
+            print("cull      %8.2f ms", mean.cull);
+            print("raster    %8.2f ms", mean.raster);
+            print("present   %8.2f ms", mean.present);
+            break;
+        case HudPage::Work:
+            print("faces     %8lu", static_cast<unsigned long>(mean.faces));
+            print("submitted %8lu", static_cast<unsigned long>(mean.submitted));
+            print("culled    %8lu", static_cast<unsigned long>(mean.faces - mean.submitted));
+            print("drawn     %8lu", static_cast<unsigned long>(mean.rasterized));
+            print("z-tested  %8lu px", static_cast<unsigned long>(mean.tested));
+            print("written   %8lu px", static_cast<unsigned long>(mean.written));
+            print("occluded  %8lu", static_cast<unsigned long>(mean.rejected));
+            break;
+        case HudPage::Output:
+            print("changed   %8lu cells", mean.cells);
+            print("output    %8lu bytes", mean.bytes);
+            print("bandwidth %8.1f KiB/s", static_cast<double>(mean.bytes) * fps / 1024.0);
+            break;
+        default:
+            break;
+    }
+}
+
+void render_hud(const Camera &cam, const float fps, const float cost, Presenter &presenter)
 {
-    if (g_hud_pair)
-        attron(COLOR_PAIR(g_hud_pair));
+    char line[64];
+
+    std::snprintf(line, sizeof(line), "framerate %6d fps", static_cast<int>(std::round(fps)));
+    presenter.overlay(0, line);
+    std::snprintf(line, sizeof(line), "zoom      %6.1f x", cam.zoom);
+    presenter.overlay(1, line);
+    std::snprintf(line, sizeof(line), "azimuth   %6.1f deg", clamp0(rad2deg(cam.azimuth)));
+    presenter.overlay(2, line);
+    std::snprintf(line, sizeof(line), "altitude  %6.1f deg", clamp0(rad2deg(cam.altitude)));
+    presenter.overlay(3, line);
+    std::snprintf(line, sizeof(line), "output    %6lu bytes", presenter.bytes);
+    presenter.overlay(4, line);
+    std::snprintf(line, sizeof(line), "changed   %6lu cells", presenter.cells);
+    presenter.overlay(5, line);
+    std::snprintf(line, sizeof(line), "frame     %6.1f ms", 1000.0f * cost);
+    presenter.overlay(6, line);
+}
+
+// sgr of frame base and of cells without material for theme, see AnsiEncoder
+static std::pair<std::string, std::string> ansi_style(const bool color_support, const Theme theme)
+{
+    if (!color_support)
+        return {"\x1b[0m", "\x1b[39m"};
 
-    mvprintw(0, 0, "framerate %6d fps", static_cast<int>(std::round(fps)));
-    mvprintw(1, 0, "zoom      %6.1f x", cam.zoom);
-    mvprintw(2, 0, "azimuth   %6.1f deg", clamp0(rad2deg(cam.azimuth)));
-    mvprintw(3, 0, "altitude  %6.1f deg", clamp0(rad2deg(cam.altitude)));
+    const Vec3 black(0.0f, 0.0f, 0.0f);
+    const Vec3 white(1.0f, 1.0f, 1.0f);
+
+    switch (theme)
+    {
+        case Theme::Light:
+            return {"\x1b[0m" + truecolor(white, true), truecolor(black)};
+        case Theme::Transparent:
+            return {"\x1b[0m", truecolor(white)};
+        case Theme::Dark:
+        default:
+            return {"\x1b[0m" + truecolor(black, true), truecolor(white)};
+    }
+}
 
-    if (g_hud_pair)
-        attroff(COLOR_PAIR(g_hud_pair));
+// ncurses presenter or raw ansi one writing truecolor materials with single write per frame
+static std::unique_ptr<Presenter> make_presenter(const bool ansi, const bool color_support, const Theme theme, const std::vector<Material> &materials)
+{
+    if (!ansi)
+    {
+        auto screen = std::make_unique<Screen>(color_support);
+        screen->overlay_pair = g_hud_pair;
+        return screen;
+    }
+
+    const auto [base, plain] = ansi_style(color_support, theme);
+    return std::make_unique<AnsiScreen>(color_support ? materials : std::vector<Material>{}, base, plain, STDOUT_FILENO);
+}
+
+// applies requested transforms, previews of partially loaded model skip acceleration structures
+static void prepare_model(const Args &args, const Light &light, Object &obj, const bool complete)
+{
+    // normalize to unit cube
+    obj.normalize();
+
+    // resize to make model >= 0.5 screen size
+    obj.scale(3.0f);
+
+    // flip faces winding order
+    if (args.flip_faces)
+        obj.flip_faces();
+
+    // invert along axes
+    if (args.invert_x)
+        obj.invert_x();
+
+    if (args.invert_y)
+        obj.invert_y();
+
+    if (args.invert_z)
+        obj.invert_z();
+
+    if (complete)
+    {
+        // simplified meshes for views where full one is finer than characters
+        if (args.use_lod)
+            obj.build_lods();
+
+        // hierarchy for skipping off-screen and back-facing clusters
+        obj.build_bvh();
+    }
+
+    // light fixed to object, shading never changes
+    if (args.static_light)
+    {
+        Renderer::bake_light(obj.mesh, light);
+        for (auto &lod : obj.lods)
+            Renderer::bake_light(lod.mesh, light);
+    }
+}
+
+// transforms baked into clustered sidecar
+static uint32_t stream_flags(const Args &args)
+{
+    return (args.color_support ? ClusterFile::COLOR : 0) | (args.flip_faces ? ClusterFile::FLIP : 0) | (args.invert_x ? ClusterFile::INVERT_X : 0)
+         | (args.invert_y ? ClusterFile::INVERT_Y : 0) | (args.invert_z ? ClusterFile::INVERT_Z : 0) | (args.use_lod ? ClusterFile::LOD : 0);
+}
+
+// streamed model from clustered sidecar if streaming is on and sidecar is still valid
+static bool restore_stream(const Args &args, const std::string &input, Object &obj)
+{
+    return args.stream_budget > 0 && ClusterFile::load(obj, input, stream_flags(args), args.stream_budget << 20);
+}
+
+// writes clustered sidecar of complete prepared model and swaps model for streamed one, keeps it in memory if that fails
+static void stream_model(const Args &args, const std::string &input, Object &obj)
+{
+    if (args.stream_budget > 0 && !obj.stream && ClusterFile::save(obj, input, stream_flags(args)))
+    {
+        restore_stream(args, input, obj);
+    }
+}
+
+// loads model, from sidecar if it is still valid, and applies requested transforms, false if it can't be loaded
+static bool prepare_object(const Args &args, const std::string &input, const unsigned threads, const Light &light, Object &obj)
+{
+    if (restore_stream(args, input, obj))
+    {
+        return true;
+    }
+
+    if (!args.use_cache || !MeshCache::load(obj, input, args.color_support))
+    {
+        if (!obj.load(input, args.color_support, threads))
+        {
+            return false;
+        }
+
+        if (args.use_cache)
+        {
+            MeshCache::save(obj, input, args.color_support);
+        }
+    }
+
+    prepare_model(args, light, obj, true);
+    stream_model(args, input, obj);
+    return true;
+}
+
+// colors of materials, ncurses pairs are set up again only when table changed, applied is hash of current table
+static void apply_materials(const Args &args, const std::vector<Material> &materials, Presenter &presenter, uint64_t &applied)
+{
+    const uint64_t hash = material_hash(materials);
+    if (!args.color_support || hash == applied)
+        return;
+
+    if (!args.ansi)
+    {
+        init_colors(materials, args.theme);
+
+        // hud pair follows material pairs
+        if (auto *screen = dynamic_cast<Screen *>(&presenter))
+            screen->overlay_pair = g_hud_pair;
+    }
+
+    presenter.set_materials(materials);
+    applied = hash;
+}
+
+// headless export parameters from command line
+static ExportOptions export_options(const Args &args)
+{
+    ExportOptions options;
+    options.frames = args.export_frames;
+    options.width = args.bench_width;
+    options.height = args.bench_height;
+    options.format = args.export_format;
+    options.static_light = args.static_light;
+    options.color_support = args.color_support;
+    options.front_to_back = args.front_to_back;
+    options.animate_altitude = args.animate_altitude;
+    options.animate_azimuth = args.animate_azimuth;
+    options.speed_altitude = args.speed_altitude;
+    options.speed_azimuth = args.speed_azimuth;
+    std::tie(options.base, options.plain) = ansi_style(args.color_support, args.theme);
+    return options;
 }
 
 void handle_control(const int ch, Camera &cam)
@@ -391,40 +870,139 @@ void handle_control(const int ch, Camera &cam)
 int main(int argc, char **argv)
 {
     const Args args = parse_args(argc, argv);
+    const sigset_t wait_mask = block_resize_signal();
 
-    // load object
-    Object obj;
-    if (!obj.load(args.input_file.string(), args.color_support))
+    // models given by directory or several paths are exported one file each
+    const std::vector<std::string> inputs = Batch::collect(args.input_files);
+
+    if (inputs.empty())
     {
+        std::cerr << "error: no obj files found\n";
         return 1;
     }
 
-    // normalize to unit cube
-    obj.normalize();
+    const bool batch = inputs.size() > 1 || std::filesystem::is_directory(args.input_files.front());
 
-    // resize to make model >= 0.5 screen size
-    obj.scale(3.0f);
+    if (batch && args.export_frames == 0)
+    {
+        std::cerr << "error: several models need --export\n";
+        return 1;
+    }
 
-    // flip faces winding order
-    if (args.flip_faces)
-        obj.flip_faces();
+    // view
+    Camera cam(args.zoom);  // constructor with zoom
+    Light light;            // default
+    HudPage hud = HudPage::Off;
 
-    // invert along axes
-    if (args.invert_x)
-        obj.invert_x();
+    // change initial view
+    cam.altitude = deg2rad(args.altitude);
+    cam.azimuth = deg2rad(args.azimuth);
 
-    if (args.invert_y)
-        obj.invert_y();
+    if (batch)
+    {
+        if (!args.export_file.empty())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(args.export_file, error);
+            if (error)
+            {
+                std::cerr << "error: can't create output directory " << args.export_file.string() << '\n';
+                return 1;
+            }
+        }
 
-    if (args.invert_z)
-        obj.invert_z();
+        // workers split models, every model is parsed by its worker alone
+        const auto items = Batch::plan(inputs, args.export_file, args.export_format);
+        const auto load = [&](const std::string &input, Object &model) { return prepare_object(args, input, 1, light, model); };
+
+        return Batch::run(items, load, cam, light, export_options(args), args.threads, std::cout) ? 0 : 1;
+    }
+
+    const std::string &input = inputs.front();
+
+    // workers for tiled rasterization
+    ThreadPool pool(args.threads);
+
+    // headless run, model is loaded completely first
+    if (args.bench_frames > 0 || args.export_frames > 0)
+    {
+        Object obj;
+        if (!prepare_object(args, input, args.threads, light, obj))
+        {
+            return 1;
+        }
+
+        if (args.bench_frames > 0)
+        {
+            BenchmarkOptions options;
+            options.frames = args.bench_frames;
+            options.width = args.bench_width;
+            options.height = args.bench_height;
+            options.json = args.bench_json;
+            options.static_light = args.static_light;
+            options.color_support = args.color_support;
+            options.front_to_back = args.front_to_back;
+
+            Benchmark::run(std::filesystem::path(input).filename().string(), obj, cam, light, options, pool, std::cout);
+            return 0;
+        }
+
+        const ExportOptions options = export_options(args);
+
+        std::ofstream file;
+        if (!args.export_file.empty())
+        {
+            file.open(args.export_file, std::ios::binary);
+            if (!file)
+            {
+                std::cerr << "error: can't open output file " << args.export_file.string() << '\n';
+                return 1;
+            }
+        }
+
+        if (!Exporter::run(obj, cam, light, options, pool, args.export_file.empty() ? std::cout : file))
+        {
+            std::cerr << "error: can't write exported frames\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // missing file is reported before terminal is taken over
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(input, error))
+    {
+        std::cerr << "error: can't open file " << input << '\n';
+        return 1;
+    }
+
+    if (args.frame_cache > 0 && (args.animate_azimuth || args.animate_altitude) &&
+        Turntable::of(args.animate_azimuth, args.speed_azimuth, args.animate_altitude, args.speed_altitude).frames == 0)
+    {
+        std::cerr << "warning: animation does not repeat within " << TURNTABLE_MAX_FRAMES << " frames, frame cache is off\n";
+    }
+
+    // warnings of loader and render threads are shown after curses screen is closed, log outlives both
+    DeferredLog deferred(std::cerr);
+
+    // interactive model loads on own thread, previews of parsed part are drawn meanwhile
+    ModelLoader loader(input, args.color_support, args.use_cache, args.threads,
+                       [&](Object &model, const bool complete) {
+                           prepare_model(args, light, model, complete);
+                           if (complete)
+                               stream_model(args, input, model);
+                       },
+                       [&](Object &model) { return restore_stream(args, input, model); });
+    std::shared_ptr<const Object> model = std::make_shared<const Object>(); // empty until first preview
+    bool loading = true;
+    float shown_progress = -1.0f;
 
     // init curses
     init_ncurses();
 
-    // init colors
-    if (args.color_support)
-        init_colors(obj.materials, args.theme);
+    // init colors of theme, material colors come with model, ansi output takes them from materials directly
+    if (args.color_support && !args.ansi)
+        init_colors({}, args.theme);
 
     // buffer
     int rows;
@@ -433,106 +1011,249 @@ int main(int argc, char **argv)
     getmaxyx(stdscr, rows, cols);
 
     const float logical_y = 2.0f;
-    const float logical_x = logical_y * static_cast<float>(cols) / (static_cast<float>(rows) * CHAR_ASPECT_RATIO);
-
-    Buffer buf(static_cast<unsigned int>(cols), static_cast<unsigned int>(rows), logical_x, logical_y);
 
-    // view
-    Camera cam(args.zoom);  // constructor with zoom
-    Light light;            // default
-    bool hud = false;
+    const auto presenter = make_presenter(args.ansi, args.color_support, args.theme, {});
+    uint64_t colored = material_hash({});       // table with colors set up
 
-    // change initial view
-    cam.altitude = deg2rad(args.altitude);
-    cam.azimuth = deg2rad(args.azimuth);
+    // frames are drawn on render thread while this one presents previous frame and reads keys
+    RenderPipeline pipeline(light, args.static_light, args.color_support, args.front_to_back, pool);
 
     // animation
     bool rotate = args.animate_altitude || args.animate_azimuth;
-    auto last = SteadyClock::now();
+    auto last = SteadyClock::now();             // previous animation step
+    auto last_frame = SteadyClock::now();       // previous present
+    FrameScheduler scheduler;
+    Profiler profiler;
+    float fps = 0.0f;
+
+    // repeating animation plays from cache of one turn, stops with rotation
+    const Turntable turn = args.frame_cache > 0 ? Turntable::of(args.animate_azimuth, args.speed_azimuth, args.animate_altitude, args.speed_altitude) : Turntable{};
+    FrameCache frame_cache(light, args.static_light, args.color_support, args.front_to_back, args.frame_cache << 20);
+    bool turntable = rotate && turn.frames > 0;
+    bool turn_stale = true;                     // cache does not match model or terminal size
+    const Camera turn_start = cam;
+    double turn_time = 0.0;                     // seconds into current turn
+    size_t turn_index = 0;                      // frame of turn shown now
+    size_t pending_index = turn.frames;         // frame of turn pending request is for, frames if none
+    Buffer cached(1, 1, 1.0f, 1.0f);
 
     // optimizing drawing
     bool needs_redraw = true;
+    unsigned long pending = 0;                  // id of newest requested frame
+    bool in_flight = false;                     // requested frame is not presented yet
+
+    // changed cells of frame with overlays, cost is seconds frame took to render, stats are null for cached frame
+    auto show = [&](const Buffer &buf, const Camera &view, const float cost, const RenderStats *stats) {
+        FrameProfile profile;
+        const auto now = SteadyClock::now();
+
+        const float since = std::chrono::duration<float>(now - last_frame).count();
+        fps = since > 0.0f ? 1.0f / since : 0.0f;
+        last_frame = now;
+
+        {
+            ScopedTimer timer(profile.present);
+
+            // changed cells only
+            presenter->present(buf);
+
+            // render hud
+            if (hud == HudPage::View)
+            {
+                render_hud(view, fps, scheduler.cost(), *presenter);
+            }
+            else if (hud != HudPage::Off)
+            {
+                render_profile(hud, profiler.average(), fps, *presenter);
+            }
 
-    // main render loop
+            // progress on last row until model is complete
+            if (loading)
+            {
+                char line[32];
+                std::snprintf(line, sizeof(line), "loading %5.1f %%", 100.0f * shown_progress);
+                presenter->overlay(buf.y - 1, line);
+            }
+
+            // draw buffer
+            presenter->flush();
+        }
+
+        // stages overlap, slower one limits rate
+        scheduler.end(std::max(cost, static_cast<float>(profile.present / 1000.0)));
+
+        if (stats)
+            profile.set_render(1000.0 * cost, *stats);
+        else
+            profile.cached = true;
+
+        profile.cells = presenter->cells;
+        profile.bytes = presenter->bytes;
+        profiler.record(profile);
+    };
+
+    // main loop - input, requests and presenting
     while (true)
     {
+        // idle blocks until key, resize, finished frame or loaded part of model, animation also until next step is due
+        const float timeout = needs_redraw ? 0.0f : (rotate && !in_flight) ? scheduler.remaining() : -1.0f;
+        wait_events(timeout, wait_mask, pipeline.notifier(), loading ? loader.notifier() : -1);
+
         auto now = SteadyClock::now();
-        float dt = std::chrono::duration<float>(now - last).count(); // seconds since previous frame
-        last = now;
-        float fps = dt > 0.f ? 1.f / dt : 0.f;
 
-        if (rotate) {
-            if (args.animate_altitude)
+        // one animation step per presented frame, rate is set by scheduler
+        if (rotate && !in_flight && scheduler.remaining() <= 0.0f)
+        {
+            const float dt = std::chrono::duration<float>(now - last).count(); // seconds since previous step
+            if (turntable)
             {
-                cam.rotate_down(args.speed_altitude * dt);
+                // view snaps to nearest earlier frame of turn
+                turn_time = std::fmod(turn_time + dt, static_cast<double>(turn.frames) * FRAME_DURATION);
+                turn_index = std::min(static_cast<size_t>(turn_time / FRAME_DURATION), turn.frames - 1);
+                cam = turn.view(turn_start, turn_index);
             }
-            if (args.animate_azimuth)
+            else
             {
-                cam.rotate_left(args.speed_azimuth * dt);
+                if (args.animate_altitude)
+                {
+                    cam.rotate_down(args.speed_altitude * dt);
+                }
+                if (args.animate_azimuth)
+                {
+                    cam.rotate_left(args.speed_azimuth * dt);
+                }
             }
+            last = now;
             needs_redraw = true;
         }
 
-        // handle key
-        int ch = getch();
-
-        if (ch == KEY_RESIZE)
+        // handle keys, everything typed since last wake
+        bool quit = false;
+        for (int ch = getch(); ch != ERR && !quit; ch = getch())
         {
-            getmaxyx(stdscr, rows, cols);
-            const float lx = logical_y * static_cast<float>(cols) / (static_cast<float>(rows) * CHAR_ASPECT_RATIO);
-            buf = Buffer(static_cast<unsigned int>(cols), static_cast<unsigned int>(rows), lx, logical_y);
-            needs_redraw = true;
+            if (ch == KEY_RESIZE)
+            {
+                getmaxyx(stdscr, rows, cols);
+                presenter->invalidate();
+                turn_stale = true;
+                needs_redraw = true;
+            }
+            else if (ch == 'q' || ch == 'Q')     // exit
+            {
+                quit = true;
+            }
+            else if (ch == '\t')                 // next hud page
+            {
+                hud = next_page(hud);
+                needs_redraw = true;
+            }
+            else
+            {
+                rotate = false;                // stop animation on first movement
+                handle_control(ch, cam);    // handle camera control
+                needs_redraw = true;
+            }
         }
-        else if (ch == 'q' || ch == 'Q')     // exit
+
+        if (quit)
         {
             break;
         }
-        else if (ch == '\t')                 // toggle hud
+
+        // cached turn is useless once user moves camera
+        if (turntable && !rotate)
         {
-            hud = !hud;
-            needs_redraw = true;
+            turntable = false;
+            frame_cache.clear();
         }
-        else if (ch != ERR)
+
+        // newer preview or complete model, state is read first so that complete model is not missed
+        if (loading)
         {
-            rotate = false;                // stop animation on first movement
-            handle_control(ch, cam);    // handle camera control
-            needs_redraw = true;
+            loading = loader.loading();
+
+            if (auto next = loader.take())
+            {
+                model = std::move(next);
+                apply_materials(args, model->materials, *presenter, colored);
+                turn_stale = true;
+                needs_redraw = true;
+            }
+
+            if (!loading && loader.failed())
+            {
+                endwin();
+                std::cerr << "error: can't load " << input << '\n';
+                return 1;
+            }
+
+            // progress indicator
+            if (loading && loader.progress() != shown_progress)
+            {
+                shown_progress = loader.progress();
+                needs_redraw = true;
+            }
         }
 
-        // redrawing
+        // newest view goes to render thread, unfinished older request is replaced
         if (needs_redraw)
         {
-            // clear buffer
-            buf.clear();
+            const float lx = logical_y * static_cast<float>(cols) / (static_cast<float>(rows) * CHAR_ASPECT_RATIO);
+            needs_redraw = false;
+            pending_index = turn.frames;
 
-            // render model
-            Renderer::render(buf, obj, cam, light, args.static_light, args.color_support);
+            // complete model only, previews change too often to be worth caching
+            if (turntable && !loading)
+            {
+                if (turn_stale)
+                {
+                    frame_cache.reset(model, turn, turn_start, static_cast<unsigned int>(cols), static_cast<unsigned int>(rows), lx, logical_y);
+                    turn_stale = false;
+                }
 
-            move(0, 0);
-            buf.printw();
+                // cached frame is shown at once, render thread stays idle
+                if (frame_cache.fetch(turn_index, cached))
+                {
+                    scheduler.begin();
+                    show(cached, cam, 0.0f, nullptr);
+                    continue;
+                }
 
-            // render hud
-            if (hud)
-            {
-                render_hud(cam, fps);
+                pending_index = turn_index;
             }
 
-            // draw buffer
-            refresh();
-
-            needs_redraw = false;
+            pending = pipeline.request(model, cam, static_cast<unsigned int>(cols), static_cast<unsigned int>(rows), lx, logical_y);
+            scheduler.begin();
+            in_flight = true;
         }
-        else if (hud) // update only hud
+
+        // presenting, frames of old terminal size are dropped
+        if (const Frame *frame = pipeline.take())
         {
-            render_hud(cam, fps);
-            refresh();
-        }
+            if (frame->id == pending)
+            {
+                in_flight = false;
 
-        // limiting fps
-        auto frame_deadline = now + std::chrono::duration<float>(FRAME_DURATION);
-        std::this_thread::sleep_until(frame_deadline);
+                // frame missing from turn is kept for next turns
+                if (pending_index < turn.frames && turntable)
+                {
+                    frame_cache.store(pending_index, frame->buf);
+                }
+            }
+
+            if (frame->buf.x == static_cast<unsigned int>(cols) && frame->buf.y == static_cast<unsigned int>(rows))
+            {
+                show(frame->buf, frame->cam, frame->cost, &frame->stats);
+            }
+        }
     }
 
     endwin();
+
+    if (!args.profile_file.empty() && !profiler.dump(args.profile_file))
+    {
+        std::cerr << "error: can't write profile " << args.profile_file.string() << '\n';
+        return 1;
+    }
     return 0;
 }
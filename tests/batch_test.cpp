@@ -0,0 +1,48 @@
+/*
+ * batch_test.cpp
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "entities/rendering/batch.h"
+
+// same file names from different directories must not share output in directory
+static void same_names_get_own_outputs()
+{
+    const std::vector<std::string> inputs = {"a/model.obj", "b/model.obj", "c/model.OBJ", "a/model-2.obj"};
+    const auto items = Batch::plan(inputs, "out", ExportFormat::Ansi);
+
+    CHECK(items.size() == inputs.size());
+
+    std::set<std::filesystem::path> outputs;
+    for (const auto &item : items)
+    {
+        CHECK(item.output.parent_path() == "out");
+        CHECK(item.output.extension() == ".ans");
+        outputs.insert(item.output);
+    }
+
+    CHECK(outputs.size() == items.size());
+    CHECK(items[0].output == "out/model.ans");
+    CHECK(items[1].output == "out/model-2.ans");
+}
+
+// without directory outputs stay next to inputs
+static void outputs_next_to_inputs()
+{
+    const auto items = Batch::plan({"a/model.obj", "b/model.obj"}, "", ExportFormat::Asciicast);
+
+    CHECK(items.size() == 2);
+    CHECK(items[0].output == "a/model.cast");
+    CHECK(items[1].output == "b/model.cast");
+}
+
+int main()
+{
+    same_names_get_own_outputs();
+    outputs_next_to_inputs();
+    return failures;
+}
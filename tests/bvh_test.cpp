@@ -0,0 +1,70 @@
+/*
+ * bvh_test.cpp
+ */
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "entities/geometry/object.h"
+#include "entities/rendering/buffer.h"
+#include "entities/rendering/renderer.h"
+#include "entities/view/camera.h"
+#include "entities/view/light.h"
+#include "utils/mathematics.h"
+#include "config.h"
+
+// glyph and material planes of orbit frames
+static std::vector<std::string> orbit(const Object &obj, const bool front_to_back)
+{
+    constexpr unsigned int width = 120, height = 40;
+    const float logical_y = 2.0f;
+    const float logical_x = logical_y * static_cast<float>(width) / (static_cast<float>(height) * CHAR_ASPECT_RATIO);
+
+    Buffer buf(width, height, logical_x, logical_y);
+    Renderer renderer(front_to_back);
+    renderer.reserve(obj);
+    const Light light;
+
+    std::vector<std::string> frames;
+    for (int k = 0; k < 12; k++)
+    {
+        Camera cam(0.5f + 0.4f * static_cast<float>(k));
+        cam.azimuth = deg2rad(static_cast<float>(k) * 33.0f);
+        cam.altitude = deg2rad(static_cast<float>(k) * 17.0f - 90.0f);
+
+        buf.clear();
+        renderer.render(buf, obj, cam, light, false, true);
+
+        std::string frame(buf.glyphs.begin(), buf.glyphs.end());
+        for (const uint16_t material : buf.materials)
+            frame += static_cast<char>(material & 0xFF);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// hierarchy reorders faces and vertices, drawn frames stay the same in face order and nearest first
+static void hierarchy_keeps_frames(const std::string &name)
+{
+    Object flat;
+    CHECK(flat.load(std::string(RESOURCES_DIR) + "/" + name, true, 1));
+    flat.normalize();
+    flat.scale(3.0f);
+
+    Object tree = flat;
+    tree.build_bvh();
+    CHECK(!tree.mesh.nodes.empty());
+
+    const auto expected = orbit(flat, true);
+    CHECK(expected.front().find_first_not_of(' ', 0) < expected.front().size() / 2);
+    CHECK(orbit(tree, false) == expected);
+    CHECK(orbit(tree, true) == expected);
+}
+
+int main()
+{
+    for (const char *name : {"fox.obj", "katana.obj", "linux.obj", "pslogo.obj", "tree.obj"})
+        hierarchy_keeps_frames(name);
+    return failures;
+}
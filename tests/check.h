@@ -0,0 +1,21 @@
+/*
+ * check.h
+ */
+
+#pragma once
+
+#include <iostream>
+
+// failed checks of test executable, main returns their number
+inline int failures = 0;
+
+// records failure with source line, test goes on
+#define CHECK(condition)                                                                    \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+            failures++;                                                                     \
+        }                                                                                   \
+    } while (false)
@@ -0,0 +1,55 @@
+/*
+ * materials_test.cpp
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "check.h"
+#include "entities/geometry/materials.h"
+
+static std::filesystem::path write_file(const std::string &name, const std::string &text)
+{
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary) << text;
+    return path;
+}
+
+// equal contents under other paths share one library, other contents never do
+static void cache_hit_needs_same_text()
+{
+    const auto a = write_file("objcurses_test_a.mtl", "newmtl red\nKd 1 0 0\n");
+    const auto b = write_file("objcurses_test_b.mtl", "newmtl red\nKd 1 0 0\n");
+    const auto c = write_file("objcurses_test_c.mtl", "newmtl red\nKd 0 1 0\n");
+
+    const auto la = MaterialCache::load(a.string());
+    const auto lb = MaterialCache::load(b.string());
+    const auto lc = MaterialCache::load(c.string());
+
+    CHECK(la && lb && lc);
+    CHECK(la == lb);
+    CHECK(la != lc);
+    CHECK(lc->materials.size() == 1 && lc->materials[0].diffuse.y == 1.0f);
+
+    for (const auto &path : {a, b, c})
+        std::filesystem::remove(path);
+}
+
+// tables hash by names and colors
+static void table_hash_follows_contents()
+{
+    const std::vector<Material> red{Material("red", Vec3(1.0f, 0.0f, 0.0f))};
+    const std::vector<Material> green{Material("red", Vec3(0.0f, 1.0f, 0.0f))};
+
+    CHECK(material_hash(red) == material_hash(red));
+    CHECK(material_hash(red) != material_hash(green));
+    CHECK(material_hash(red) != material_hash({}));
+}
+
+int main()
+{
+    cache_hit_needs_same_text();
+    table_hash_follows_contents();
+    return failures;
+}
@@ -6,118 +6,285 @@
 
 // helper functions
 
+// inclusive test, point on edge counts as inside
 static bool is_in_triangle(const Vec3 &pt, const Vec3 &v1, const Vec3 &v2, const Vec3 &v3, const Vec3 &normal)
 {
     const float s1 = Vec3::dot(Vec3::cross(v2 - v1, pt - v1), normal);
     const float s2 = Vec3::dot(Vec3::cross(v3 - v2, pt - v2), normal);
     const float s3 = Vec3::dot(Vec3::cross(v1 - v3, pt - v3), normal);
 
-    const bool same_sign = (s1 >= 0 && s2 >= 0 && s3 >= 0) || (s1 <= 0 && s2 <= 0 && s3 <= 0);
+    return (s1 >= 0 && s2 >= 0 && s3 >= 0) || (s1 <= 0 && s2 <= 0 && s3 <= 0);
+}
 
-    return same_sign;
+// corner v1 v2 v3 turns with polygon normal
+static bool is_convex(const Vec3 &v1, const Vec3 &v2, const Vec3 &v3, const Vec3 &normal)
+{
+    return Vec3::dot(Vec3::cross(v2 - v1, v3 - v2), normal) > 0.0f;
 }
 
-static bool is_ear(const size_t i, const std::vector<Vec3> &points, const std::vector<size_t> &indices, const Vec3 &normal)
+// main functions
+
+float lerp(const float a, const float b, const float t)
 {
-    const size_t prev = indices[(i + indices.size() - 1) % indices.size()];
-    const size_t curr = indices[i];
-    const size_t next = indices[(i + 1) % indices.size()];
+    return a + (b - a) * t;
+}
+
+// Triangulator methods
 
-    const Vec3 &v1 = points[prev];
-    const Vec3 &v2 = points[curr];
-    const Vec3 &v3 = points[next];
+bool Triangulator::triangulate(const Vec3 *points, const size_t count, std::vector<unsigned int> &triangles)
+{
+    if (count < 3)
+    {
+        return false; // insufficient points
+    }
 
-    // check if angle is convex
-    const Vec3 d1 = v2 - v1;
-    const Vec3 d2 = v3 - v2;
+    this->points = points;
 
-    if (Vec3::dot(Vec3::cross(d1, d2), normal) <= 0.0f)
+    // newell normal
+    normal = Vec3(0.0f, 0.0f, 0.0f);
+    for (size_t i = 0; i < count; i++)
     {
-        return false; // not convex
+        const Vec3 &a = points[i];
+        const Vec3 &b = points[(i + 1) % count];
+
+        normal.x += (a.y - b.y) * (a.z + b.z);
+        normal.y += (a.z - b.z) * (a.x + b.x);
+        normal.z += (a.x - b.x) * (a.y + b.y);
     }
 
-    // check for no other points inside triangle
-    for (size_t j = 0; j < indices.size(); j++)
+    if (normal.magnitude() < 1e-12f)
+    {
+        return false; // degenerate polygon
+    }
+
+    // predicates stay in 3d, projection onto plane of dominant normal axis only places vertices into grid
+    const float ax = std::fabs(normal.x), ay = std::fabs(normal.y), az = std::fabs(normal.z);
+
+    u.resize(count);
+    v.resize(count);
+
+    for (size_t i = 0; i < count; i++)
     {
-        if (j == (i - 1 + indices.size()) % indices.size() || j == i || j == (i + 1) % indices.size())
+        if (az >= ax && az >= ay)
         {
-            continue;
+            u[i] = points[i].x;
+            v[i] = normal.z > 0.0f ? points[i].y : -points[i].y;
+        }
+        else if (ax >= ay)
+        {
+            u[i] = points[i].y;
+            v[i] = normal.x > 0.0f ? points[i].z : -points[i].z;
+        }
+        else
+        {
+            u[i] = points[i].z;
+            v[i] = normal.y > 0.0f ? points[i].x : -points[i].x;
         }
+    }
+
+    // one pass classification, anything not strictly convex blocks ears
+    reflex.resize(count);
+    size_t reflex_count = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t p = (i + count - 1) % count;
+        const size_t n = (i + 1) % count;
+
+        reflex[i] = !is_convex(points[p], points[i], points[n], normal);
+        reflex_count += reflex[i];
+    }
 
-        if (is_in_triangle(points[indices[j]], v1, v2, v3, normal))
+    const auto last = static_cast<unsigned int>(count - 1);
+
+    // convex fast path, same triangles as clipping convex polygon from first vertex
+    if (reflex_count == 0)
+    {
+        for (unsigned int k = 0; k + 3 < count; k++)
         {
-            return false; // point inside triangle
+            triangles.insert(triangles.end(), {last, k, k + 1});
         }
+        triangles.insert(triangles.end(), {last - 2, last - 1, last});
+        return true;
     }
 
-    return true; // ear found
+    return clip(count, reflex_count, triangles);
 }
 
-// main functions
+void Triangulator::build_grid(const size_t count, const size_t reflex_count)
+{
+    min_u = *std::ranges::min_element(u);
+    min_v = *std::ranges::min_element(v);
+    const float max_u = *std::ranges::max_element(u);
+    const float max_v = *std::ranges::max_element(v);
 
-float lerp(const float a, const float b, const float t)
+    // about one reflex vertex per cell
+    grid = std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(reflex_count)))));
+
+    scale_u = max_u > min_u ? static_cast<float>(grid) / (max_u - min_u) : 0.0f;
+    scale_v = max_v > min_v ? static_cast<float>(grid) / (max_v - min_v) : 0.0f;
+
+    // counting sort of reflex vertices into cells
+    cell_start.assign(grid * grid + 1, 0);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reflex[i])
+            cell_start[cell_of(u[i], v[i]) + 1]++;
+    }
+
+    for (size_t c = 1; c < cell_start.size(); c++)
+    {
+        cell_start[c] += cell_start[c - 1];
+    }
+
+    cell_items.resize(reflex_count);
+    cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reflex[i])
+            cell_items[cell_fill[cell_of(u[i], v[i])]++] = static_cast<unsigned int>(i);
+    }
+}
+
+size_t Triangulator::cell_index(const float value, const float min, const float scale) const
 {
-    return a + (b - a) * t;
+    const float cell = (value - min) * scale;
+    return cell <= 0.0f ? 0 : std::min(static_cast<size_t>(cell), grid - 1);
 }
 
-std::optional<std::vector<size_t>> triangularize(const std::vector<Vec3> &points)
+size_t Triangulator::cell_of(const float pu, const float pv) const
+{
+    return cell_index(pv, min_v, scale_v) * grid + cell_index(pu, min_u, scale_u);
+}
+
+bool Triangulator::is_ear(const unsigned int i) const
 {
-    const size_t n = points.size();
-    if (n < 3)
+    if (reflex[i])
+        return false;
+
+    // rest of polygon is convex
+    if (reflex_left == 0)
+        return true;
+
+    const unsigned int a = prev[i];
+    const unsigned int c = next[i];
+
+    // only vertices that are not convex can lie inside ear, look them up in cells under triangle
+    const size_t u0 = cell_index(std::min({u[a], u[i], u[c]}), min_u, scale_u);
+    const size_t u1 = cell_index(std::max({u[a], u[i], u[c]}), min_u, scale_u);
+    const size_t v0 = cell_index(std::min({v[a], v[i], v[c]}), min_v, scale_v);
+    const size_t v1 = cell_index(std::max({v[a], v[i], v[c]}), min_v, scale_v);
+
+    for (size_t cv = v0; cv <= v1; cv++)
     {
-        return std::nullopt; // insufficient points
+        for (size_t cu = u0; cu <= u1; cu++)
+        {
+            const size_t cell = cv * grid + cu;
+
+            for (unsigned int k = cell_start[cell]; k < cell_start[cell + 1]; k++)
+            {
+                const unsigned int j = cell_items[k];
+
+                if (!reflex[j] || j == a || j == i || j == c)
+                    continue;
+
+                if (is_in_triangle(points[j], points[a], points[i], points[c], normal))
+                    return false;
+            }
+        }
     }
 
-    const Vec3 normal = Vec3::normal(points);
+    return true;
+}
 
-    if (normal.magnitude() < 1e-12f)
+bool Triangulator::clip(const size_t count, const size_t reflex_count, std::vector<unsigned int> &triangles)
+{
+    const size_t first_triangle = triangles.size();
+
+    build_grid(count, reflex_count);
+    reflex_left = reflex_count;
+
+    prev.resize(count);
+    next.resize(count);
+
+    for (size_t i = 0; i < count; i++)
     {
-        return std::nullopt; // degenerate polygon
+        prev[i] = static_cast<unsigned int>((i + count - 1) % count);
+        next[i] = static_cast<unsigned int>((i + 1) % count);
     }
 
-    // list of vertex indexes
-    std::vector<size_t> indices(n);
-    std::iota(indices.begin(), indices.end(), 0);
+    // reflex vertex only turns convex while clipping, flags in grid go stale instead of being removed
+    const auto update = [&](const unsigned int i) {
+        if (reflex[i])
+        {
+            const unsigned int p = prev[i];
+            const unsigned int n = next[i];
+            reflex[i] = !is_convex(points[p], points[i], points[n], normal);
+            reflex_left -= !reflex[i];
+        }
+    };
 
-    std::vector<size_t> result;
+    size_t remaining = count;
+    size_t misses = 0;
+    unsigned int i = 0;
 
-    // ears search
-    while (indices.size() > 3)
+    while (remaining > 3)
     {
-        bool ear_found = false;
-
-        for (std::size_t i = 0; i < indices.size(); i++)
+        if (!is_ear(i))
         {
-            if (is_ear(i, points, indices, normal))
+            // whole ring without ear
+            if (++misses > remaining)
             {
-                // adding triangle
-                size_t prev = indices[(i + indices.size() - 1) % indices.size()];
-                size_t curr = indices[i];
-                size_t next = indices[(i + 1) % indices.size()];
-
-                result.push_back(prev);
-                result.push_back(curr);
-                result.push_back(next);
-
-                // removing current ear
-                indices.erase(std::next(indices.begin(), static_cast<std::ptrdiff_t>(i)));
-                ear_found = true;
-                break;
+                triangles.resize(first_triangle);
+                return false;
             }
-        }
 
-        if (!ear_found)
-        {
-            return std::nullopt; // no valid ear
+            i = next[i];
+            continue;
         }
+
+        const unsigned int a = prev[i];
+        const unsigned int c = next[i];
+
+        triangles.insert(triangles.end(), {a, i, c});
+
+        next[a] = c;
+        prev[c] = a;
+        remaining--;
+        misses = 0;
+
+        update(a);
+        update(c);
+
+        // stale entries would dominate lookups once most reflex vertices turned convex
+        if (reflex_left > 0 && reflex_left * 2 < cell_items.size())
+            build_grid(count, reflex_left);
+
+        i = c;
     }
 
-    // adding last triangle
-    result.push_back(indices[0]);
-    result.push_back(indices[1]);
-    result.push_back(indices[2]);
+    // last triangle starts at lowest position like remaining polygon does
+    unsigned int first = i;
+    if (next[i] < first) first = next[i];
+    if (prev[i] < first) first = prev[i];
+
+    triangles.insert(triangles.end(), {first, next[first], next[next[first]]});
+    return true;
+}
+
+std::optional<std::vector<size_t>> triangularize(const std::vector<Vec3> &points)
+{
+    Triangulator triangulator;
+    std::vector<unsigned int> triangles;
+
+    if (!triangulator.triangulate(points.data(), points.size(), triangles))
+    {
+        return std::nullopt;
+    }
 
-    return result;
+    return std::vector<size_t>(triangles.begin(), triangles.end());
 }
 
 float deg2rad(float degree)
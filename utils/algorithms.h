@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <optional>
 #include <vector>
@@ -20,7 +22,36 @@ T clamp(const T &value, const T &low, const T &high)
     return (value < low) ? low : (value > high ? high : value);
 }
 
-// polygon triangulation
+// polygon triangulation with reusable memory
+// convex polygons are fanned after one pass, others are ear clipped with not convex vertices in uniform grid
+class Triangulator {
+public:
+    // appends triangles as positions in points, false if polygon is degenerate or has no ear
+    bool triangulate(const Vec3 *points, size_t count, std::vector<unsigned int> &triangles);
+
+private:
+    const Vec3 *points = nullptr;              // polygon being triangulated
+    Vec3 normal;
+    std::vector<float> u, v;                    // polygon projected onto plane of dominant normal axis
+    std::vector<char> reflex;                   // vertex is not strictly convex
+    std::vector<unsigned int> prev, next;       // remaining polygon ring
+    size_t reflex_left = 0;                     // reflex vertices still in ring
+
+    size_t grid = 1;                            // cells per axis
+    float min_u = 0.0f, min_v = 0.0f;
+    float scale_u = 0.0f, scale_v = 0.0f;       // cells per unit
+    std::vector<unsigned int> cell_start;       // reflex vertices of cell c are cell_items[cell_start[c] .. cell_start[c + 1])
+    std::vector<unsigned int> cell_items;
+    std::vector<unsigned int> cell_fill;
+
+    bool clip(size_t count, size_t reflex_count, std::vector<unsigned int> &triangles);
+    void build_grid(size_t count, size_t reflex_count);
+    [[nodiscard]] size_t cell_index(float value, float min, float scale) const;
+    [[nodiscard]] size_t cell_of(float pu, float pv) const;
+    [[nodiscard]] bool is_ear(unsigned int i) const;
+};
+
+// allocating variant
 std::optional<std::vector<size_t>> triangularize(const std::vector<Vec3> &points);
 
 // transformations
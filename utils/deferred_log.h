@@ -0,0 +1,57 @@
+/*
+ * deferred_log.h
+ */
+
+#pragma once
+
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// holds everything written to stream during its lifetime and writes it there at the end,
+// diagnostics of worker threads then do not draw over curses screen
+class DeferredLog {
+public:
+    explicit DeferredLog(std::ostream &stream) : stream(stream), original(stream.rdbuf(&buffer)) {}
+
+    ~DeferredLog()
+    {
+        stream.rdbuf(original);
+        stream << buffer.text;
+        stream.flush();
+    }
+
+    DeferredLog(const DeferredLog &) = delete;
+    DeferredLog &operator=(const DeferredLog &) = delete;
+
+private:
+    // unbuffered, every write appends under lock so threads may write at once
+    class Buffer : public std::streambuf {
+    public:
+        std::mutex mutex;
+        std::string text;
+
+    protected:
+        int_type overflow(const int_type c) override
+        {
+            if (traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
+
+            std::lock_guard lock(mutex);
+            text += traits_type::to_char_type(c);
+            return c;
+        }
+
+        std::streamsize xsputn(const char *s, const std::streamsize count) override
+        {
+            std::lock_guard lock(mutex);
+            text.append(s, static_cast<size_t>(count));
+            return count;
+        }
+    };
+
+    std::ostream &stream;
+    Buffer buffer;
+    std::streambuf *original;
+};
@@ -0,0 +1,125 @@
+/*
+ * files.cpp
+ */
+
+#include "files.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    mapped_data(std::exchange(other.mapped_data, nullptr)),
+    mapped_size(std::exchange(other.mapped_size, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        mapped_data = std::exchange(other.mapped_data, nullptr);
+        mapped_size = std::exchange(other.mapped_size, 0);
+    }
+
+    return *this;
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "error: can't open file " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        std::cerr << "error: can't open file " << filename << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    // empty file is valid, just nothing to map
+    if (st.st_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        std::cerr << "error: can't map file " << filename << std::endl;
+        return false;
+    }
+
+    // parser walks file front to back
+    madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    mapped_data = static_cast<const char *>(addr);
+    mapped_size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::advise(const size_t offset, const size_t length, const int advice) const
+{
+    if (!mapped_data || offset >= mapped_size)
+    {
+        return;
+    }
+
+    const size_t page = page_size();
+    const size_t begin = offset / page * page;
+    const size_t end = std::min(offset + length, mapped_size);
+
+    madvise(const_cast<char *>(mapped_data) + begin, end - begin, advice);
+}
+
+size_t MappedFile::page_size()
+{
+    static const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page;
+}
+
+void MappedFile::close()
+{
+    if (mapped_data)
+    {
+        munmap(const_cast<char *>(mapped_data), mapped_size);
+    }
+
+    mapped_data = nullptr;
+    mapped_size = 0;
+}
+
+std::filesystem::path unique_temp(const std::filesystem::path &target)
+{
+    std::string name = target.string() + ".XXXXXX";
+
+    const int fd = mkstemp(name.data());
+    if (fd < 0)
+    {
+        return {};
+    }
+
+    // mkstemp creates it private, renamed file gets usual permissions
+    fchmod(fd, 0644);
+    ::close(fd);
+    return name;
+}
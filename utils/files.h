@@ -0,0 +1,77 @@
+/*
+ * files.h
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// read-only memory mapped file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // map whole file into memory
+    bool open(const std::string &filename);
+    void close();
+
+    [[nodiscard]] const char *data() const { return mapped_data; }
+    [[nodiscard]] size_t size() const { return mapped_size; }
+    [[nodiscard]] std::string_view view() const { return {mapped_data, mapped_size}; }
+
+    // madvise hint for byte range, rounded out to whole pages
+    void advise(size_t offset, size_t length, int advice) const;
+
+    [[nodiscard]] static size_t page_size();
+
+private:
+    const char *mapped_data = nullptr;
+    size_t mapped_size = 0;
+};
+
+// new empty file with unique name next to target, written in full and then renamed over target,
+// so concurrent writers of same target never share an inode - empty path if it can't be created
+std::filesystem::path unique_temp(const std::filesystem::path &target);
+
+// bounded reader over mapped bytes, reads past end fail and leave position unchanged
+class BoundedReader {
+public:
+    explicit BoundedReader(const std::string_view data) : data(data) {}
+
+    bool read(void *out, const size_t bytes)
+    {
+        if (bytes > data.size() - pos)
+            return false;
+
+        std::memcpy(out, data.data() + pos, bytes);
+        pos += bytes;
+        return true;
+    }
+
+    bool read_string(std::string &out, const size_t length)
+    {
+        if (length > data.size() - pos)
+            return false;
+
+        out.assign(data.data() + pos, length);
+        pos += length;
+        return true;
+    }
+
+    [[nodiscard]] size_t position() const { return pos; }
+
+private:
+    std::string_view data;
+    size_t pos = 0;
+};
@@ -0,0 +1,41 @@
+/*
+ * frame_scheduler.cpp
+ */
+
+#include "frame_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+FrameScheduler::FrameScheduler(const float target) : target(target), period(target) {}
+
+void FrameScheduler::begin()
+{
+    started = Clock::now();
+}
+
+void FrameScheduler::end()
+{
+    end(std::chrono::duration<float>(Clock::now() - started).count());
+}
+
+void FrameScheduler::end(const float cost)
+{
+    average = average > 0.0f ? average + FRAME_COST_SMOOTHING * (cost - average) : cost;
+
+    // slower rate follows right away, faster one only once cost clearly fits it
+    const float multiple = std::max(1.0f, std::ceil(average / target));
+    const float current = period / target;
+
+    if (multiple > current || average < FRAME_RATE_HYSTERESIS * multiple * target)
+    {
+        period = multiple * target;
+    }
+
+    deadline = started + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(period));
+}
+
+float FrameScheduler::remaining() const
+{
+    return std::max(0.0f, std::chrono::duration<float>(deadline - Clock::now()).count());
+}
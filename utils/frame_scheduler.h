@@ -0,0 +1,32 @@
+/*
+ * frame_scheduler.h
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include "config.h"
+
+// paces animation - frame interval is smallest multiple of target that covers measured frame cost
+class FrameScheduler {
+public:
+    explicit FrameScheduler(float target = FRAME_DURATION);
+
+    void begin();   // frame work starts now
+    void end();     // frame work finished, updates cost and interval
+    void end(float cost);   // same with cost measured by caller, for work overlapping other stages
+
+    [[nodiscard]] float cost() const { return average; }       // smoothed seconds of frame work
+    [[nodiscard]] float interval() const { return period; }    // seconds between frame starts
+    [[nodiscard]] float remaining() const;                      // seconds until next frame is due, 0 if overdue
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    float target;
+    float average = 0.0f;
+    float period;
+    Clock::time_point started{};
+    Clock::time_point deadline{};
+};
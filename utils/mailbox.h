@@ -0,0 +1,43 @@
+/*
+ * mailbox.h
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// lock-free single-slot mailbox between one producer and one consumer thread (triple buffer)
+// producer fills back and publishes it, consumer fetches newest published value, older unread value is replaced
+template<typename T>
+class Mailbox {
+public:
+    explicit Mailbox(const T &initial) : slots{initial, initial, initial} {}
+
+    Mailbox(const Mailbox &) = delete;
+    Mailbox &operator=(const Mailbox &) = delete;
+
+    // producer side
+    T &back() { return slots[back_index]; }
+    void publish() { back_index = ready.exchange(back_index | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // consumer side, front stays valid until next successful fetch
+    bool fetch()
+    {
+        if (!(ready.load(std::memory_order_relaxed) & FRESH))
+            return false;
+
+        front_index = ready.exchange(front_index, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    T &front() { return slots[front_index]; }
+
+private:
+    static constexpr unsigned int INDEX = 3;   // slot index bits of ready
+    static constexpr unsigned int FRESH = 4;   // ready slot was published and not fetched yet
+
+    std::array<T, 3> slots;
+    unsigned int back_index = 0;                // owned by producer
+    unsigned int front_index = 1;               // owned by consumer
+    std::atomic<unsigned int> ready{2};         // slot exchanged between them
+};
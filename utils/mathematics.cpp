@@ -130,3 +130,61 @@ Vec3 Vec3::to_screen(const Vec3 &v, float zoom, float logical_x, float logical_y
     };
 }
 
+// Mat3 methods
+
+Mat3 Mat3::operator*(const Mat3 &other) const
+{
+    Mat3 r;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            r.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j];
+        }
+    }
+    return r;
+}
+
+Vec3 Mat3::operator*(const Vec3 &v) const
+{
+    return {
+        m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+        m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+        m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z
+    };
+}
+
+Mat3 Mat3::transpose() const
+{
+    Mat3 r;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            r.m[i][j] = m[j][i];
+        }
+    }
+    return r;
+}
+
+Mat3 Mat3::rotation_y(const float radians)
+{
+    const float cos_theta = std::cos(radians);
+    const float sin_theta = std::sin(radians);
+
+    Mat3 r;
+    r.m[0][0] = cos_theta;  r.m[0][2] = -sin_theta;
+    r.m[2][0] = sin_theta;  r.m[2][2] = cos_theta;
+    return r;
+}
+
+Mat3 Mat3::rotation_x(const float radians)
+{
+    const float cos_theta = std::cos(radians);
+    const float sin_theta = std::sin(radians);
+
+    Mat3 r;
+    r.m[1][1] = cos_theta;  r.m[1][2] = -sin_theta;
+    r.m[2][1] = sin_theta;  r.m[2][2] = cos_theta;
+    return r;
+}
@@ -48,3 +48,23 @@ public:
     [[nodiscard]] static Vec3 to_screen(const Vec3 &v, float zoom, float logical_x, float logical_y);   // transform to viewport
 
 };
+
+// 3x3 matrix structure, row major
+class Mat3 {
+public:
+    float m[3][3] = {
+        {1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f}
+    };
+
+    Mat3() = default; // identity
+
+    Mat3 operator*(const Mat3 &other) const;    // composition, other is applied first
+    Vec3 operator*(const Vec3 &v) const;        // transformation of vector
+
+    [[nodiscard]] Mat3 transpose() const;       // inverse for rotations
+
+    [[nodiscard]] static Mat3 rotation_y(float radians); // same rotation as Vec3::rotate_y
+    [[nodiscard]] static Mat3 rotation_x(float radians); // same rotation as Vec3::rotate_x
+};
@@ -0,0 +1,54 @@
+/*
+ * memory.h
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// cache line alignment of simd scratch data
+inline constexpr size_t SCRATCH_ALIGNMENT = 64;
+
+// allocator for scratch arrays - aligned storage, growing leaves new elements uninitialized
+template<typename T, size_t Alignment = SCRATCH_ALIGNMENT>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    explicit AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    [[nodiscard]] T *allocate(const size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    // default initialization instead of value initialization, vector::resize does not zero
+    template<typename U, typename... Args>
+    void construct(U *p, Args &&...args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+            ::new (static_cast<void *>(p)) U;
+        else
+            ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
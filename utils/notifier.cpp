@@ -0,0 +1,48 @@
+/*
+ * notifier.cpp
+ */
+
+#include "notifier.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+Notifier::Notifier()
+{
+    if (::pipe(ends) != 0)
+    {
+        ends[0] = ends[1] = -1;
+        return;
+    }
+
+    for (const int end : ends)
+    {
+        ::fcntl(end, F_SETFL, O_NONBLOCK);
+        ::fcntl(end, F_SETFD, FD_CLOEXEC);
+    }
+}
+
+Notifier::~Notifier()
+{
+    for (const int end : ends)
+    {
+        if (end >= 0)
+            ::close(end);
+    }
+}
+
+void Notifier::notify()
+{
+    // full pipe is still readable, lost byte does not matter
+    if (ends[1] >= 0)
+    {
+        const char byte = 1;
+        [[maybe_unused]] const ssize_t n = ::write(ends[1], &byte, 1);
+    }
+}
+
+void Notifier::drain()
+{
+    char bytes[64];
+    while (ends[0] >= 0 && ::read(ends[0], bytes, sizeof(bytes)) > 0) {}
+}
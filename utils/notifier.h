@@ -0,0 +1,24 @@
+/*
+ * notifier.h
+ */
+
+#pragma once
+
+// self pipe that makes event of one thread readable for select of another
+class Notifier {
+public:
+    Notifier();
+    ~Notifier();
+
+    Notifier(const Notifier &) = delete;
+    Notifier &operator=(const Notifier &) = delete;
+
+    void notify();  // makes descriptor readable, never blocks
+    void drain();   // consumes all notifications
+
+    // readable descriptor, -1 if pipe could not be created
+    [[nodiscard]] int fd() const { return ends[0]; }
+
+private:
+    int ends[2] = {-1, -1};
+};
@@ -0,0 +1,48 @@
+/*
+ * parallel.h
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// number of worker threads for given request, 0 - all hardware threads
+inline unsigned worker_count(const unsigned requested = 0)
+{
+    if (requested > 0)
+        return requested;
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// run task(i) for every i in [0, count), items are taken dynamically by up to threads workers
+template<typename Task>
+void parallel_for(const size_t count, const unsigned threads, Task &&task)
+{
+    const size_t workers = std::min<size_t>(count, worker_count(threads));
+
+    if (workers <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+            task(i);
+    };
+
+    std::vector<std::jthread> pool;
+    pool.reserve(workers - 1);
+
+    for (size_t w = 1; w < workers; w++)
+        pool.emplace_back(worker);
+
+    worker(); // calling thread works too
+}
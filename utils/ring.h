@@ -0,0 +1,30 @@
+/*
+ * ring.h
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// ring of last N records on heap, pushing never allocates, not synchronized - one thread writes and reads it
+template<typename T, size_t N>
+class Ring {
+public:
+    void push(const T &value)
+    {
+        slots[written % N] = value;
+        written++;
+    }
+
+    [[nodiscard]] size_t total() const { return written; }                  // records ever pushed
+    [[nodiscard]] size_t size() const { return std::min(written, N); }      // records kept
+
+    // record by age, 0 is newest, age below size
+    [[nodiscard]] const T &newest(const size_t age) const { return slots[(written - 1 - age) % N]; }
+
+private:
+    std::vector<T> slots = std::vector<T>(N);
+    size_t written = 0;
+};
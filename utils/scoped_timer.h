@@ -0,0 +1,23 @@
+/*
+ * scoped_timer.h
+ */
+
+#pragma once
+
+#include <chrono>
+
+// adds milliseconds of its lifetime to target, two clock reads per scope
+class ScopedTimer {
+public:
+    explicit ScopedTimer(double &target) : target(target), start(Clock::now()) {}
+    ~ScopedTimer() { target += std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    double &target;
+    Clock::time_point start;
+};
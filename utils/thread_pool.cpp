@@ -0,0 +1,92 @@
+/*
+ * thread_pool.cpp
+ */
+
+#include "thread_pool.h"
+
+#include "parallel.h"
+
+ThreadPool::ThreadPool(const unsigned threads)
+{
+    const unsigned total = worker_count(threads);
+
+    workers.reserve(total - 1);
+    for (unsigned i = 1; i < total; i++)
+    {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(const size_t count, const std::function<void(size_t)> &task)
+{
+    if (workers.empty() || count <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        job = &task;
+        job_count = count;
+        next.store(0);
+        active = static_cast<unsigned>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    drain();
+
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::drain()
+{
+    for (size_t i = next.fetch_add(1); i < job_count; i = next.fetch_add(1))
+    {
+        (*job)(i);
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    size_t seen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+
+            if (stopping)
+                return;
+
+            seen = generation;
+        }
+
+        drain();
+
+        {
+            std::lock_guard lock(mutex);
+            if (--active == 0)
+                done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * thread_pool.h
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// persistent workers for per frame parallel loops
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0); // total threads including caller, 0 - all hardware threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    [[nodiscard]] unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // run task(i) for every i in [0, count) and wait for all, calling thread works too
+    // not reentrant - task must not call parallel_for of same pool
+    void parallel_for(size_t count, const std::function<void(size_t)> &task);
+
+private:
+    void worker_loop();
+    void drain();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;   // new job or stop
+    std::condition_variable done;   // all workers finished job
+
+    const std::function<void(size_t)> *job = nullptr;
+    size_t job_count = 0;
+    std::atomic<size_t> next{0};
+
+    size_t generation = 0;  // incremented for every job
+    unsigned active = 0;    // workers still inside current job
+    bool stopping = false;
+};
@@ -4,6 +4,8 @@
 
 #include "tools.h"
 
+#include <charconv>
+
 std::optional<int> safe_stoi(const std::string &token)
 {
     try {
@@ -30,4 +32,104 @@ std::optional<float> safe_stof(const std::string &token)
     catch (const std::exception &) {
         return std::nullopt;
     }
-}
\ No newline at end of file
+}
+
+// from_chars does not accept leading plus unlike streams
+static std::string_view strip_plus(std::string_view token)
+{
+    if (token.size() > 1 && token[0] == '+' && token[1] != '-')
+    {
+        token.remove_prefix(1);
+    }
+
+    return token;
+}
+
+std::optional<int> parse_int(std::string_view token)
+{
+    token = strip_plus(token);
+
+    int v = 0;
+    const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), v, 10);
+    if (ec != std::errc() || ptr != token.data() + token.size() || token.empty())
+        return std::nullopt;
+    return v;
+}
+
+std::optional<float> parse_float(std::string_view token)
+{
+    token = strip_plus(token);
+
+    float v = 0.0f;
+    const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), v);
+    if (ec != std::errc() || ptr != token.data() + token.size() || token.empty())
+        return std::nullopt;
+    return v;
+}
+
+bool is_blank(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+std::string_view next_line(std::string_view &text)
+{
+    const size_t end = text.find('\n');
+    const std::string_view line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    return line;
+}
+
+std::string_view next_token(std::string_view &line)
+{
+    size_t begin = 0;
+    while (begin < line.size() && is_blank(line[begin]))
+        begin++;
+
+    size_t end = begin;
+    while (end < line.size() && !is_blank(line[end]))
+        end++;
+
+    const std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return token;
+}
+
+bool split_command(std::string_view line, std::string_view &cmd, std::string_view &arguments)
+{
+    cmd = next_token(line);
+
+    if (cmd.empty() || cmd[0] == '#') // comment
+    {
+        return false;
+    }
+
+    arguments = line;
+    return true;
+}
+
+void append_json(std::string &out, const std::string_view text)
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    for (const char c : text)
+    {
+        const auto byte = static_cast<unsigned char>(c);
+
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (byte < 0x20)
+        {
+            out += "\\u00";
+            out += HEX[byte >> 4];
+            out += HEX[byte & 0xF];
+        }
+        else
+        {
+            out += c;
+        }
+    }
+}
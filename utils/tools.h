@@ -6,7 +6,21 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 
 // safe operators of conversion
 std::optional<int> safe_stoi(const std::string &token);      // from string to int
-std::optional<float> safe_stof(const std::string &token);    // from string to float
\ No newline at end of file
+std::optional<float> safe_stof(const std::string &token);    // from string to float
+
+// in place conversion of whole token, no allocation
+std::optional<int> parse_int(std::string_view token);
+std::optional<float> parse_float(std::string_view token);
+
+// in place tokenizing
+bool is_blank(char c);                          // space, tab or carriage return
+std::string_view next_line(std::string_view &text);     // cut line until '\n'
+std::string_view next_token(std::string_view &line);    // cut token until blank
+bool split_command(std::string_view line, std::string_view &cmd, std::string_view &arguments);  // first token and rest, false for blank or comment line
+
+// contents of json string, control characters as \u escapes
+void append_json(std::string &out, std::string_view text);